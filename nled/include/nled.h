@@ -27,6 +27,80 @@ namespace nled
 	**/
 	bool DisplayExists(int inDisplayNumber);
 
+	/**
+	@brief Sets how long InitDisplays waits for the devices to answer the interface query in milli seconds, defaults to 1000
+
+	All devices are queried at the same time, every answer is read as soon as it arrives
+	**/
+	void SetHandshakeTimeout(int inMilliseconds);
+
+	/**
+	@brief Returns how long InitDisplays waits for the devices to answer the interface query in milli seconds
+	**/
+	int GetHandshakeTimeout();
+
+	/**
+	@brief Returns the time between the interface query and the answer of the device the display belongs to in milli seconds, 0 if the configuration was cached, -1 if display isn't valid
+	**/
+	float GetHandshakeLatency(int inDisplayNumber);
+
+	/**
+	@brief Only probes usb devices with the given vendor and product id (0 matches any id) when initializing displays
+
+	inSerialNumber limits the filter to a single device, nullptr matches any device. A port is probed when it matches one of the filters,
+	ports that aren't usb devices never match. Without filters all ports are probed (default)
+	**/
+	void AddPortFilter(int inVendorId, int inProductId, const char* inSerialNumber = nullptr);
+
+	/**
+	@brief Removes all port filters, all ports are probed again
+	**/
+	void ClearPortFilters();
+
+	/**
+	@brief Sets the file the configuration of usb devices is cached in by serial number, nullptr disables the cache (default)
+
+	Cached devices aren't queried when initializing displays, they're verified by their usb serial number and opened with the cached configuration.
+	The cache is updated after every initialization, remove the file after reconfiguring a device
+	**/
+	void SetDeviceCache(const char* inPath);
+
+	/**
+	@brief Called by UpdateDisplays for every display that connected or disconnected
+	**/
+	typedef void (*DisplayCallback)(int inDisplayNumber, bool inConnected);
+
+	/**
+	@brief Watches for led devices that connect or disconnect after InitDisplays, off by default. Returns false when not supported (linux only)
+
+	New ports are probed in the background with the port filters, device cache and handshake timeout, change those while hot plug is disabled.
+	The devices found are added by UpdateDisplays
+	**/
+	bool SetHotPlug(bool inEnabled);
+
+	/**
+	@brief Returns if led devices that connect or disconnect are picked up
+	**/
+	bool GetHotPlug();
+
+	/**
+	@brief Adds the devices that connected and removes the ones that disconnected since the last call, returns if the displays changed
+
+	Call it between frames from the thread that sends them, the other devices keep sending while a device is added or removed.
+	New displays have no data yet, set it before the next frame. Display numbers returned by GetAvailableDisplayNumbers before are no longer valid
+	**/
+	bool UpdateDisplays();
+
+	/**
+	@brief Sets the function called by UpdateDisplays for every display that connected or disconnected, nullptr disables it
+	**/
+	void SetDisplayCallback(DisplayCallback inCallback);
+
+	/**
+	@brief Returns a number that changes every time displays are added or removed, by InitDisplays, ClearDisplays or UpdateDisplays
+	**/
+	unsigned int GetDisplayGeneration();
+
 	//////////////////////////////////////////////////////////////////////////
 	// Display Controls
 	//////////////////////////////////////////////////////////////////////////
@@ -52,10 +126,15 @@ namespace nled
 	int GetMaxDisplayByteSize();
 
 	/**
-	@brief Returns the amount of bytes per led (3 -> RGB)
+	@brief Returns the amount of bytes per led of the default pixel format (3 -> RGB)
 	**/
 	int GetBytesPerLed();
 
+	/**
+	@brief Returns the amount of bytes per led in the display data of a display (3 -> RGB, 4 -> RGBW), -1 if display isn't valid
+	**/
+	int GetBytesPerLed(int inDisplayNumber);
+
 	/**
 	@brief Returns the stride of the display, -1 if display number isn't valid
 	**/
@@ -76,6 +155,78 @@ namespace nled
 	**/
 	int GetTotalDisplayByteSize();
 
+	/**
+	@brief Order in which the strips connected to a single pin are wired
+	**/
+	enum class StripOrder : int
+	{
+		Serpentine	= 0,				//< Every strip runs opposite to the previous one (zigzag)
+		Progressive	= 1,				//< Every strip runs in the same direction
+	};
+
+	/**
+	@brief Clockwise rotation of the display data relative to the physical panel
+	**/
+	enum class Rotation : int
+	{
+		None		= 0,
+		CW90		= 1,				//< Display data is transposed, strips run along the display columns
+		CW180		= 2,
+		CW270		= 3,				//< Display data is transposed, strips run along the display columns
+	};
+
+	/**
+	@brief Describes how the led strips of a device are wired relative to the display data
+
+	The default describes horizontal serpentine strips, where the first strip direction is reported by the device.
+	The mapping is resolved once when the topology is set, every topology converts as fast as the default one
+	**/
+	struct Topology
+	{
+		Topology() : mOrder(StripOrder::Serpentine), mRotation(Rotation::None), mMirrorX(false), mMirrorY(false)	{ }
+
+		StripOrder	mOrder;				//< Serpentine or progressive strips
+		Rotation	mRotation;			//< Rotation applied before mirroring
+		bool		mMirrorX;			//< Mirrors the display data horizontally
+		bool		mMirrorY;			//< Mirrors the display data vertically
+	};
+
+	/**
+	@brief Sets the wiring of the device the display belongs to, applies to both displays of the device
+
+	Rotating by 90 or 270 degrees swaps the display stride and height.
+	Don't call this while EndDisplay is running
+	**/
+	bool SetDisplayTopology(int inDisplayNumber, const Topology& inTopology);
+
+	/**
+	@brief Returns the wiring of the device the display belongs to
+	**/
+	Topology GetDisplayTopology(int inDisplayNumber);
+
+	/**
+	@brief Color layout of the leds connected to a device
+	**/
+	enum class PixelFormat : int
+	{
+		RGB			= 0,				//< 3 bytes per led, send as GRB
+		RGBW		= 1,				//< 4 bytes per led, send as GRBW (SK6812)
+	};
+
+	/**
+	@brief Sets the color layout of the device the display belongs to, applies to both displays of the device
+
+	When inExtractWhite is set the display data stays RGB and the white channel is derived from it,
+	otherwise RGBW display data holds 4 bytes per led. Changes the display byte size, 
+	make sure the data set with SetData is large enough. Don't call this while EndDisplay is running
+	**/
+	bool SetDisplayPixelFormat(int inDisplayNumber, PixelFormat inFormat, bool inExtractWhite = false);
+
+	/**
+	@brief Returns the color layout of the device the display belongs to
+	**/
+	PixelFormat GetDisplayPixelFormat(int inDisplayNumber);
+
 	/**
 	@brief Returns all the available unique display numbers
 
@@ -88,6 +239,11 @@ namespace nled
 	// Sending
 	//////////////////////////////////////////////////////////////////////////
 
+	/**
+	@brief Identifies a frame handed to the devices, frame numbers increase by one for every frame (EndDisplay, SubmitFrame and Blackout)
+	**/
+	typedef unsigned long long FrameHandle;
+
 	/**
 	@brief Sets the data for a single display
 	**/
@@ -98,9 +254,360 @@ namespace nled
 	**/
 	unsigned char* GetData(int inDisplayIndex);
 
+	/**
+	@brief Flags inRowCount rows of a display, starting at inFirstRow, as changed since the previous EndDisplay or SubmitFrame
+
+	Only used when dirty tracking is set to Explicit, a negative row count flags all rows from inFirstRow onwards.
+	Submitted frames detect changed rows themselves. Don't call this while EndDisplay is running
+	**/
+	void MarkDirty(int inDisplayNumber, int inFirstRow = 0, int inRowCount = -1);
+
 	/**
 	@brief Converts display data and sends it to the hardware
+
+	Returns once the display data is converted, the frame is written to the devices while the next frame is converted.
+	The returned frame can be waited on with WaitForFrame
+	**/
+	FrameHandle EndDisplay();
+
+	/**
+	@brief Copies the display data in to library owned buffers and converts and sends it in the background
+
+	Returns as soon as the data is copied, the display data can be changed right away.
+	Every device buffers two frames, when both are still waiting for conversion this waits for the oldest one.
+	EndDisplay and Blackout wait for all submitted frames to be converted, changing the display layout waits for all frames to be written
+	**/
+	FrameHandle SubmitFrame();
+
+	/**
+	@brief Returns if every device finished writing the frame (or skipped it because it didn't change)
+	**/
+	bool IsFramePresented(FrameHandle inFrame);
+
+	/**
+	@brief Waits until every device finished writing the frame
+	**/
+	void WaitForFrame(FrameHandle inFrame);
+
+	/**
+	@brief Returns the last frame every device finished writing, 0 when none
+	**/
+	FrameHandle GetPresentedFrame();
+
+	/**
+	@brief Sends an all black frame to every device, the frame is precomputed and the display data is left untouched
+	**/
+	void Blackout();
+
+	/**
+	@brief Enables or disables skipping frames that are identical to the last frame send to a device, enabled by default
+	**/
+	void SetSkipUnchangedFrames(bool inSkip);
+
+	/**
+	@brief Sets the size in bytes of the chunks frames are streamed to the devices in, 0 (default) writes a frame once it's completely converted
+
+	When set every device converts a frame in chunks of whole strip rows and writes each chunk as soon as it's converted,
+	starting with the sync header. Sizes of a few USB packets up to the serial driver buffer (512 - 4096) work best.
+	Don't call this while EndDisplay is running
+	**/
+	void SetStreamChunkSize(int inByteCount);
+
+	/**
+	@brief Returns the size of the chunks frames are streamed to the devices in, 0 when frames aren't streamed
+	**/
+	int GetStreamChunkSize();
+
+	/**
+	@brief Returns if frames identical to the last frame send to a device are skipped
+	**/
+	bool GetSkipUnchangedFrames();
+
+	/**
+	@brief Returns the amount of frames written to the device the display belongs to, -1 if display isn't valid
+	**/
+	int GetSentFrameCount(int inDisplayNumber);
+
+	/**
+	@brief Returns the amount of unchanged frames that weren't written to the device the display belongs to, -1 if display isn't valid
+	**/
+	int GetSkippedFrameCount(int inDisplayNumber);
+
+	/**
+	@brief Enables or disables dropping stale frames when a device can't keep up, disabled by default
+
+	When enabled a frame isn't written before the previous one left the serial driver (TIOCOUTQ), so frames don't pile up
+	in the driver buffer. A newer frame replaces the waiting one, the device always ends up with the latest frame.
+	Waits for all frames to be written first
+	**/
+	void SetDropStaleFrames(bool inDrop);
+
+	/**
+	@brief Returns if stale frames are dropped when a device can't keep up
+	**/
+	bool GetDropStaleFrames();
+
+	/**
+	@brief Returns the amount of frames replaced by a newer frame before they were written to the device the display belongs to, -1 if display isn't valid
+	**/
+	int GetDroppedFrameCount(int inDisplayNumber);
+
+	/**
+	@brief Returns the amount of frames that couldn't be written completely to the device the display belongs to, -1 if display isn't valid
+
+	A write that times out without progress gives up on the rest of the frame, the next frame is always written
+	**/
+	int GetPartialFrameCount(int inDisplayNumber);
+
+	/**
+	@brief Connection state and error counters of a device
+	**/
+	struct DeviceStatus
+	{
+		DeviceStatus() : mOnline(false), mErrorCount(0), mLostFrames(0), mReconnectCount(0), mReconnectAttempts(0)	{ }
+
+		bool		mOnline;			//< If frames are written to the device, false from a failed connection until the device is reconnected
+		int			mErrorCount;		//< Amount of times the connection failed
+		int			mLostFrames;		//< Amount of frames that weren't written because the device was down
+		int			mReconnectCount;	//< Amount of times the device was reconnected
+		int			mReconnectAttempts;	//< Amount of failed reconnects since the device went down
+	};
+
+	/**
+	@brief Returns the connection state and error counters of the device the display belongs to, a default status if display isn't valid
+
+	A device goes down when writing to it fails, the other devices keep going. Frames for a device that's down are presented without being written,
+	the device is reopened in the background, with a growing delay between attempts, and used again once it reports the same configuration
+	**/
+	DeviceStatus GetDeviceStatus(int inDisplayNumber);
+
+	/**
+	@brief How the converted frames are written to the devices
+	**/
+	enum class OutputBackend : int
+	{
+		Threads		= 0,				//< Every device has it's own transmit thread that blocks on the serial port
+		Events		= 1,				//< A few writer threads drive the non blocking serial ports of all devices with epoll (linux only)
+	};
+
+	/**
+	@brief Selects how the converted frames are written to the devices, defaults to Threads
+
+	Events spreads the devices over inThreadCount writer threads, one is enough for dozens of devices.
+	Waits for all frames to be written first. Returns false when the backend isn't available, the devices keep their transmit threads
+	**/
+	bool SetOutputBackend(OutputBackend inBackend, int inThreadCount = 1);
+
+	/**
+	@brief Returns how the converted frames are written to the devices
+	**/
+	OutputBackend GetOutputBackend();
+
+	//////////////////////////////////////////////////////////////////////////
+	// Frame Pacing
+	//////////////////////////////////////////////////////////////////////////
+
+	/**
+	@brief Sets the frame rate the devices expect, defaults to 30
+
+	Drives the sync pulse send with every frame (requested at 75% of the frame time) and the frame pacing clock.
+	Don't call this while EndDisplay is running
+	**/
+	void SetTargetFrameRate(float inFramesPerSecond);
+
+	/**
+	@brief Returns the frame rate the devices expect
+	**/
+	float GetTargetFrameRate();
+
+	/**
+	@brief Enables or disables frame pacing, disabled by default
+
+	When enabled the writes of consecutive frames are spaced out at the target frame rate, regardless of when
+	EndDisplay or SubmitFrame are called. Frames handed over early wait for their tick, EndDisplay and SubmitFrame
+	block when the devices are more than a frame ahead. Enabling restarts the pacing clock
+	**/
+	void SetFramePacing(bool inEnabled);
+
+	/**
+	@brief Returns if frame pacing is enabled
+	**/
+	bool GetFramePacing();
+
+	/**
+	@brief What happens to a frame that's handed over after its tick when frame pacing is enabled
+	**/
+	enum class LateFramePolicy : int
+	{
+		Present		= 0,				//< The frame is written right away, the pacing clock restarts from it
+		Drop		= 1,				//< The missed ticks are dropped, the frame is written at the next tick to keep the cadence
+	};
+
+	/**
+	@brief Selects what happens to frames that miss their tick, defaults to Present
+	**/
+	void SetLateFramePolicy(LateFramePolicy inPolicy);
+
+	/**
+	@brief Returns what happens to frames that miss their tick
+	**/
+	LateFramePolicy GetLateFramePolicy();
+
+	/**
+	@brief Measured output timing of a device since the last reset
+	**/
+	struct FrameTiming
+	{
+		FrameTiming() : mFrameRate(0.0f), mJitter(0.0f), mFrameCount(0), mLateFrames(0), mDroppedTicks(0), mWriteSkew(0.0f), mMeanWriteSkew(0.0f), mMaxWriteSkew(0.0f)	{ }
+
+		float		mFrameRate;			//< Achieved frame rate, from the mean interval between the starts of frame writes
+		float		mJitter;			//< Standard deviation of the interval between frame writes in milli seconds
+		int			mFrameCount;		//< Amount of intervals measured
+		int			mLateFrames;		//< Amount of frames that missed their tick, counted for all devices
+		int			mDroppedTicks;		//< Amount of ticks dropped because of late frames, counted for all devices
+		float		mWriteSkew;			//< Time between the first and the last device starting to write the last frame in milli seconds
+		float		mMeanWriteSkew;		//< Mean start of write skew between the devices in milli seconds
+		float		mMaxWriteSkew;		//< Largest start of write skew between the devices in milli seconds
+	};
+
+	/**
+	@brief Returns the measured output timing of the device the display belongs to
+
+	Frames that aren't written because they didn't change aren't measured
+	**/
+	FrameTiming GetFrameTiming(int inDisplayNumber);
+
+	/**
+	@brief Clears the measured output timing of every device and the pacing counters
+	**/
+	void ResetFrameTiming();
+
+	/**
+	@brief Selects the device the display belongs to as frame sync master, -1 (default) lets every device show frames on it's own
+
+	The other devices are send their frames in slave mode, they show a frame on the frame sync pulse of the master.
+	Every frame the master is written after all slaves received their frame, the master is never skipped.
+	The master needs to be wired to the frame sync input of the slaves
+	**/
+	bool SetFrameSyncMaster(int inDisplayNumber);
+
+	/**
+	@brief Returns the first display of the frame sync master, -1 when every device shows frames on it's own
+	**/
+	int GetFrameSyncMaster();
+
+	//////////////////////////////////////////////////////////////////////////
+	// Real Time Output
+	//////////////////////////////////////////////////////////////////////////
+
+	/**
+	@brief Scheduling, cpu placement and memory locking of the library threads
+	**/
+	struct RealTimeSettings
+	{
+		RealTimeSettings() : mPriority(0), mOutputCpus(0), mConversionCpus(0), mLockMemory(false)	{ }
+
+		int					mPriority;			//< Real time (SCHED_FIFO) priority of the output and conversion threads (1 - 99), 0 keeps the default scheduling
+		unsigned long long	mOutputCpus;		//< Cpus the output, transmit and writer threads run on, one bit per cpu, 0 doesn't pin them
+		unsigned long long	mConversionCpus;	//< Cpus the conversion workers run on, one bit per cpu, 0 doesn't pin them
+		bool				mLockMemory;		//< Locks all memory of the process (mlockall) and prefaults the frame buffers of every device
+	};
+
+	/**
+	@brief What the library threads and memory actually got, depends on the privileges of the process
+	**/
+	struct RealTimeStatus
+	{
+		RealTimeStatus() : mPriority(0), mOutputPinned(false), mConversionPinned(false), mMemoryLocked(false), mBuffersLocked(false)	{ }
+
+		int			mPriority;			//< Lowest real time priority the threads got, 0 when one of them runs with the default scheduling
+		bool		mOutputPinned;		//< If the output, transmit and writer threads run on the requested cpus
+		bool		mConversionPinned;	//< If the conversion workers run on the requested cpus
+		bool		mMemoryLocked;		//< If all memory of the process is locked
+		bool		mBuffersLocked;		//< If the frame buffers of every device are locked, also when locking all memory isn't allowed
+	};
+
+	/**
+	@brief Applies real time settings to all library threads and the frame buffers, defaults to no real time behavior
+
+	Waits for all frames to be written and restarts the output, transmit, writer and conversion threads.
+	What isn't allowed falls back to the default behavior, a priority above the real time limit of the process is lowered to that limit.
+	Prints a warning for everything that couldn't be applied, returns what was obtained
+	**/
+	RealTimeStatus SetRealTimeSettings(const RealTimeSettings& inSettings);
+
+	/**
+	@brief Returns the requested real time settings
+	**/
+	RealTimeSettings GetRealTimeSettings();
+
+	/**
+	@brief Returns what the library threads and memory got from the last real time settings
+	**/
+	RealTimeStatus GetRealTimeStatus();
+
+	//////////////////////////////////////////////////////////////////////////
+	// Conversion
+	//////////////////////////////////////////////////////////////////////////
+
+	/**
+	@brief Available implementations to convert display data in to led data streams
+
+	All engines produce identical output, InitDisplays selects the fastest one for the current cpu
+	**/
+	enum class ConversionEngine : int
+	{
+		Scalar		= 0,				//< Reference implementation, wires every pixel and spreads the bits one by one
+		Transpose	= 1,				//< Gathers color planes and transposes them using a vectorized kernel
+		Table		= 2,				//< Fused gamma, wiring and bit spread lookup tables
+	};
+
+	/**
+	@brief Selects the engine used to convert display data
+	**/
+	void SetConversionEngine(ConversionEngine inEngine);
+
+	/**
+	@brief Returns the engine used to convert display data
+	**/
+	ConversionEngine GetConversionEngine();
+
+	/**
+	@brief Returns a human readable name for the engine
+	**/
+	const char* GetConversionEngineName(ConversionEngine inEngine);
+
+	/**
+	@brief Sets the amount of threads that convert a single device, 0 (default) uses one thread per core
+
+	Large devices are split in to chunks of strip rows, converted in parallel on a shared pool of worker threads.
+	Don't call this while EndDisplay is running
+	**/
+	void SetConversionThreadCount(int inThreadCount);
+
+	/**
+	@brief Returns the amount of threads that convert a single device
+	**/
+	int GetConversionThreadCount();
+
+	/**
+	@brief How EndDisplay detects which display rows changed, unchanged rows reuse the led data of the previous frame
+	**/
+	enum class DirtyTracking : int
+	{
+		Off			= 0,				//< Every frame converts all display data
+		Explicit	= 1,				//< Only rows flagged with MarkDirty, or displays that received new data with SetData, are converted
+		RowHash		= 2,				//< Every row is hashed each frame, rows with a changed hash are converted
+	};
+
+	/**
+	@brief Selects how changed display rows are detected, defaults to Off
+	**/
+	void SetDirtyTracking(DirtyTracking inMode);
+
+	/**
+	@brief Returns how changed display rows are detected
 	**/
-	void EndDisplay();
+	DirtyTracking GetDirtyTracking();
 }
 
@@ -0,0 +1,111 @@
+#pragma once
+
+// Led devices
+#include <nleddevice.h>
+
+// Public interface
+#include <nled.h>
+
+/**
+@brief Converts display data in to the led data streams send to the hardware devices
+**/
+
+namespace nled
+{
+	/**
+	@brief Creates the gamma and conversion tables and selects the fastest conversion engine
+	**/
+	void InitConversion(float inGammaValue);
+
+	/**
+	@brief Deletes all conversion tables
+	**/
+	void ClearConversion();
+
+	/**
+	@brief Creates the output buffers of a device, the device layout needs to be known
+	**/
+	void CreateConversionBuffers(NLedDevice& ioDevice);
+
+	/**
+	@brief Deletes the output buffers of a device
+	**/
+	void DeleteConversionBuffers(NLedDevice& ioDevice);
+
+	/**
+	@brief Prefaults and locks the output buffers of a device when memory locking is requested, the device needs to be idle
+	**/
+	void PrefaultConversionBuffers(NLedDevice& ioDevice);
+
+	/**
+	@brief Sets the led color layout of a device and recreates the conversion buffers
+
+	When inExtractWhite is set the display data stays RGB and the white channel is derived from it
+	**/
+	void SetPixelFormat(NLedDevice& ioDevice, PixelFormat inFormat, bool inExtractWhite);
+
+	/**
+	@brief Rebuilds the panel offset of every led in output order, call after changing the device topology
+	**/
+	void BuildGatherIndex(NLedDevice& ioDevice);
+
+	/**
+	@brief Flags the strip rows that sample inRowCount display rows starting at inFirstRow of a panel (0 or 1) for conversion
+
+	A negative row count flags all rows from inFirstRow onwards
+	**/
+	void MarkRowsDirty(NLedDevice& ioDevice, int inPanel, int inFirstRow, int inRowCount);
+
+	/**
+	@brief Flags inRowCount display rows starting at inFirstRow of a panel in ioRows, one flag per display row of both panels
+
+	Used to collect changed rows without touching the conversion state, a negative row count flags all rows from inFirstRow onwards
+	**/
+	void FlagRows(const NLedDevice& inDevice, vector<unsigned char>& ioRows, int inPanel, int inFirstRow, int inRowCount);
+
+	/**
+	@brief Flags the strip rows of every display row flagged in ioRows for conversion and clears the flags
+	**/
+	void ApplyRowFlags(NLedDevice& ioDevice, vector<unsigned char>& ioRows);
+
+	/**
+	@brief Copies the user data of both panels in to frame slot inSlot and flags the rows that differ from the previous slot
+	**/
+	void SnapshotFrame(NLedDevice& ioDevice, int inSlot);
+
+	/**
+	@brief Fills the first 3 bytes of a frame with sync info, the sync pulse is requested at 75% of the target frame time
+
+	Frame sync slaves are send '%' instead of '*', they show the frame on the sync pulse of the master
+	**/
+	void WriteSyncHeader(const NLedDevice& inDevice, unsigned char* outFrame);
+}
+
+/**
+@brief Converts the char data of every panel in to led data streams using the selected engine
+
+Returns if any strip row was converted, when not the led data is identical to the previous conversion
+**/
+bool PixelsToLed(NLedDevice* inDevice);
+
+/**
+@brief Converts the char data of every panel in to led data streams using the given engine
+
+Honors the selected dirty tracking mode, only strip rows that changed are converted again
+**/
+bool PixelsToLed(NLedDevice* inDevice, nled::ConversionEngine inEngine);
+
+/**
+@brief Called after every converted chunk with the amount of bytes at the start of the led data that are final
+
+inConverted tells if any strip row of the chunk was converted, when not the chunk is identical to the previous conversion
+**/
+typedef void (*NLedChunkDone)(NLedDevice* inDevice, int inByteCount, bool inConverted, void* inContext);
+
+/**
+@brief Converts the char data of every panel in to led data streams in chunks of at least one strip row
+
+Streams the led data while the rest of the frame converts. The sync header is final before the first chunk,
+a chunk holds as many strip rows as fit in inChunkSize bytes. Honors the selected dirty tracking mode like PixelsToLed
+**/
+bool PixelsToLed(NLedDevice* inDevice, nled::ConversionEngine inEngine, int inChunkSize, NLedChunkDone inChunkDone, void* inContext);
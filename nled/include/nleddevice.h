@@ -3,16 +3,43 @@
 // Serial Includes
 #include <serial/ww_serial.h>
 
+// Public types
+#include <nled.h>
+
+// Standard Includes
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 using namespace std;
 using namespace serial;
 
+const static int				sBytesPerLed(3);							//< Total amount of bytes per led
+const static int				sLedCharBufferOffset(3);					//< Holds the hardware device offset to color buffers
+const static int				sFrameSlotCount(2);							//< Amount of submitted frames a device buffers (double buffering)
+
+struct NLedDevice;
+
+/**
+@brief Work handed to the output thread of a device
+**/
+typedef void (*NLedOutputTask)(NLedDevice* inDevice);
+
 /**
 @brief Describes the hardware led layout 
 **/
 struct NLedDevice
 {
-	NLedDevice(const PortInfo& inPortInfo) : mValid(false), mPortInfo(inPortInfo), mRGBDataPanelOne(nullptr), mRGBDataPanelTwo(nullptr)							
+	NLedDevice(const PortInfo& inPortInfo) : mPinCount(8), mValid(false), mPixelFormat(nled::PixelFormat::RGB), mExtractWhite(false), mSyncSlave(false), mDisplayBytesPerLed(sBytesPerLed), mLedBytesPerLed(sBytesPerLed), mPortInfo(inPortInfo), mHandshakeLatency(0.0f), mUserDataPanelOne(nullptr), mUserDataPanelTwo(nullptr), mRGBDataPanelOne(nullptr), mRGBDataPanelTwo(nullptr), mConvertedData(nullptr), mPlaneData(nullptr), mGatherIndex(nullptr), mSentData(nullptr), mBlackData(nullptr), mSentValid(false), mSentFrames(0), mSkippedFrames(0), mDroppedFrames(0), mPartialFrames(0), mOnline(true), mErrorCount(0), mLostFrames(0), mReconnectCount(0), mReconnectAttempts(0), mTimedOutWrites(0), mOutputTask(nullptr), mStopOutput(false), mTransmitData(nullptr), mTransmitSize(0), mTransmitFrame(0), mStopTransmit(false), mWriterIndex(-1), mTransmitWritten(0), mTransmitStarted(false), mTransmitFailed(false), mTransmitProgress(), mTimedFrames(0), mIntervalSum(0.0), mIntervalSquareSum(0.0), mRowHashesValid(false), mFrameValid(false), mSubmitSlot(0), mOutputSlot(0), mQueuedFrames(0), mPresentedFrame(0)							
 	{
+		for(int i=0; i < sFrameSlotCount; i++)
+		{
+			mFrameData[i] = nullptr;
+			mFrameNumbers[i] = 0;
+		}
 		mConnection.setPort(inPortInfo.port);
 		mConnection.setBaudrate(9600);
 		mConnection.setTimeout(Timeout::simpleTimeout(1000));
@@ -21,19 +48,98 @@ struct NLedDevice
 	Serial			mConnection;							//< Serial connection to micro controller
 	int				mStripLength;							//< Amount of leds on one strip
 	int				mLedHeight;								//< Amount of leds in height
+	int				mPinCount;								//< Amount of parallel output pins (8, 16 or 32)
 	bool			mValid;									//< If the led device is valid and operationg
 	bool			mLayout;								//< Left to right / right to left
+	nled::Topology	mTopology;								//< How the strips are wired relative to the display data
+	nled::PixelFormat mPixelFormat;							//< Color layout of the leds
+	bool			mExtractWhite;							//< If the white channel is derived from RGB display data
+	bool			mSyncSlave;								//< If frames are send in slave mode, latched on the frame sync pulse of the master
+	int				mDisplayBytesPerLed;					//< Amount of bytes per led in the display data
+	int				mLedBytesPerLed;						//< Amount of bytes per led send to the device
 	string			mDeviceName;							//< Interface name
 	int				mUUID;									//< Unique identifier of device
 	PortInfo		mPortInfo;								//< Port information
 	int				mPanelUUIDOne;						//< Panel id number 1
 	int				mPanelUUIDTwo;						//< Panel id number 2
 	int				mByteSize;								//< Total number of bytes associated with displays associated with this device
+	float			mHandshakeLatency;						//< Time between the interface query and the complete answer in milli seconds
 
 	// User Data
-	unsigned char*	mRGBDataPanelOne;						//< RGB data for panel one
-	unsigned char*	mRGBDataPanelTwo;						//< RGB data for panel two
+	unsigned char*	mUserDataPanelOne;						//< Display data set by the application for panel one
+	unsigned char*	mUserDataPanelTwo;						//< Display data set by the application for panel two
+	vector<unsigned char> mMarkedRows;						//< Display rows the application flagged as changed since the last frame, one flag per display row of both panels
+
+	// Conversion Input
+	unsigned char*	mRGBDataPanelOne;						//< RGB data for panel one, the user data or a submitted frame
+	unsigned char*	mRGBDataPanelTwo;						//< RGB data for panel two, the user data or a submitted frame
 	
 	// Panel Data
 	unsigned char*	mConvertedData;							//< Holds the converted RGB pixel data
+	unsigned char*	mPlaneData;								//< Scratch space for the gamma corrected color planes, sized like the led data so every row range converted in parallel gathers in to the planes of it's own first row
+	unsigned int*	mGatherIndex;							//< Panel byte offset of every led in output order
+
+	// Send State
+	unsigned char*	mSentData;								//< Copy of the last converted frame handed to the transmit thread, written to the device from here
+	unsigned char*	mBlackData;								//< Precomputed all black frame, send on blackout
+	atomic<bool>	mSentValid;								//< If mSentData holds the frame the device currently shows, cleared by the transmitter when a write fails
+	int				mSentFrames;							//< Amount of frames written to the device, guarded by the transmit lock
+	int				mSkippedFrames;							//< Amount of frames not written because they didn't change, guarded by the transmit lock
+	int				mDroppedFrames;							//< Amount of frames replaced by a newer frame while waiting for the previous one to drain, guarded by the transmit lock
+	int				mPartialFrames;							//< Amount of frames that couldn't be written completely, guarded by the transmit lock
+
+	// Connection State
+	atomic<bool>	mOnline;								//< If frames are written to the device, cleared when the connection fails until the device is reconnected, changed with the transmit lock held
+	int				mErrorCount;							//< Amount of times the connection failed, guarded by the transmit lock
+	int				mLostFrames;							//< Amount of frames not written because the device was down, guarded by the transmit lock
+	int				mReconnectCount;						//< Amount of times the device was reconnected, guarded by the transmit lock
+	int				mReconnectAttempts;						//< Amount of failed reconnects since the device went down, guarded by the reconnect lock
+	chrono::steady_clock::time_point mReconnectDue;			//< When the device is reconnected next, guarded by the reconnect lock
+	int				mTimedOutWrites;						//< Amount of frames in a row of which the write timed out, the device is taken down after a couple, guarded by the transmit lock
+
+	// Output Thread
+	thread					mOutputThread;					//< Long lived thread that converts and writes frames to the device
+	mutex					mOutputMutex;					//< Guards the output task and stop request
+	condition_variable		mOutputSignal;					//< Wakes up the output thread when a task is set or it needs to stop
+	NLedOutputTask			mOutputTask;					//< Task the output thread runs next, cleared when done
+	bool					mStopOutput;					//< Tells the output thread to exit
+
+	// Transmit Thread
+	thread					mTransmitThread;				//< Long lived thread that writes converted frames to the device, while the output thread converts the next one
+	mutex					mTransmitMutex;					//< Guards the transmit state
+	condition_variable		mTransmitSignal;				//< Signaled when a frame is handed to the transmit thread and when it's written
+	const unsigned char*	mTransmitData;					//< Frame the transmit thread writes, null when idle
+	int						mTransmitSize;					//< Amount of bytes of the frame that can be written, grows while a frame is streamed
+	unsigned long long		mTransmitFrame;					//< Frame number presented when the write finishes
+	chrono::steady_clock::time_point mTransmitDue;			//< When the write of the frame starts, set by the frame pacing
+	bool					mStopTransmit;					//< Tells the transmit thread to exit after the current write
+	int						mWriterIndex;					//< Event writer that writes the device instead of the transmit thread, -1 when none
+	int						mTransmitWritten;				//< Amount of bytes of the frame the event writer wrote
+	bool					mTransmitStarted;				//< If the write of the frame started, until then a newer frame can replace it
+	bool					mTransmitFailed;				//< If the write of the frame timed out or failed
+	chrono::steady_clock::time_point mTransmitProgress;		//< When the event writer last got bytes of the frame in to the serial driver, the write times out without progress
+
+	// Frame Timing
+	chrono::steady_clock::time_point mLastWriteStart;		//< When the write of the last frame started, guarded by the transmit lock
+	int						mTimedFrames;					//< Amount of intervals between writes measured since the last reset
+	double					mIntervalSum;					//< Sum of the measured intervals in seconds
+	double					mIntervalSquareSum;				//< Sum of the squared measured intervals
+
+	// Dirty Tracking
+	vector<unsigned char>		mDirtyStrips;				//< Strip rows that need to be converted again, one flag per strip row
+	vector<int>					mRowStripOffsets;			//< Where the strip rows of a display row start in mRowStrips (panel one rows first)
+	vector<int>					mRowStrips;					//< Strip rows that sample a display row, indexed through mRowStripOffsets
+	vector<unsigned long long>	mRowHashes;					//< Hash of every display row when it was last converted
+	bool						mRowHashesValid;			//< If the row hashes describe the data in mConvertedData
+
+	// Submitted Frames
+	unsigned char*				mFrameData[sFrameSlotCount];	//< Library owned copies of the display data of both panels, panel two follows panel one
+	vector<unsigned char>		mFrameRows[sFrameSlotCount];	//< Display rows of a slot that differ from the previous slot, one flag per display row of both panels
+	unsigned long long			mFrameNumbers[sFrameSlotCount];	//< Frame number stored in a slot
+	chrono::steady_clock::time_point mFrameDue[sFrameSlotCount];	//< When the write of the frame in a slot is due
+	bool						mFrameValid;				//< If the previous slot holds the last frame converted
+	int							mSubmitSlot;				//< Slot the next submitted frame is copied to, owned by the application thread
+	int							mOutputSlot;				//< Slot the output thread sends next, owned by the output thread
+	atomic<int>					mQueuedFrames;				//< Amount of submitted frames the output thread didn't convert
+	atomic<unsigned long long>	mPresentedFrame;			//< Number of the last frame written to the device (or skipped)
 };
\ No newline at end of file
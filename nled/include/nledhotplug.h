@@ -0,0 +1,41 @@
+#pragma once
+
+// Standard Includes
+#include <vector>
+#include <string>
+
+/**
+@brief Watches the device directory for serial ports that appear or disappear
+
+The watcher runs on it's own thread and hands the changed ports over in batches, events that arrive close together,
+like the steps udev takes to create a port, end up in the same batch. When events are lost every port that's present is reported as added.
+Only available on linux (inotify), ports are only found by InitDisplays elsewhere
+**/
+
+namespace nled
+{
+	/**
+	@brief Called on the watcher thread with the paths of the ports that appeared or disappeared, a port that's replaced is reported in both
+	**/
+	typedef void (*PortsChanged)(const std::vector<std::string>& inAdded, const std::vector<std::string>& inRemoved);
+
+	/**
+	@brief Returns if the port watcher is available on this platform
+	**/
+	bool IsPortWatcherSupported();
+
+	/**
+	@brief Starts watching for ports, stops the previous watcher first. Returns false when not supported
+	**/
+	bool StartPortWatcher(PortsChanged inChanged);
+
+	/**
+	@brief Stops watching for ports, waits for the current batch to be handled
+	**/
+	void StopPortWatcher();
+
+	/**
+	@brief Returns if the port watcher is running
+	**/
+	bool IsPortWatcherRunning();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Public types
+#include <nled.h>
+
+// Standard Includes
+#include <thread>
+#include <stddef.h>
+
+/**
+@brief Applies the real time settings (SetRealTimeSettings) to library threads and buffers
+
+Threads are configured by the thread that creates them, the application thread, right after they're started.
+What a thread or buffer got is gathered in the status returned by GetRealTimeStatus
+**/
+
+namespace nled
+{
+	/**
+	@brief What a library thread does, decides the cpus it's pinned to
+	**/
+	enum class ThreadRole : int
+	{
+		Output		= 0,				//< Output, transmit and writer threads
+		Conversion	= 1,				//< Conversion workers
+	};
+
+	/**
+	@brief Stores the settings, locks or unlocks all memory and resets the status, threads and buffers are configured afterwards
+	**/
+	void ApplyRealTimeSettings(const RealTimeSettings& inSettings);
+
+	/**
+	@brief Applies the priority and cpus of the role to a started thread
+	**/
+	void ConfigureThread(std::thread& ioThread, ThreadRole inRole);
+
+	/**
+	@brief Touches every page of a buffer when memory locking is requested, locks the buffer when all memory can't be locked
+
+	The buffer needs to be idle, every page is written with it's own value
+	**/
+	void PrefaultBuffer(void* ioData, size_t inSize);
+
+	/**
+	@brief Unlocks a buffer locked by PrefaultBuffer, call before the buffer is freed. Does nothing for buffers that aren't locked on their own
+	**/
+	void ReleaseBuffer(void* ioData);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+@brief Bit transpose kernels used to turn gamma corrected color planes in to parallel led bit streams
+
+A group holds one color channel byte for each of the parallel output pins (8, 16 or 32).
+The transpose turns a group in to 8 output words, one for every bit of the channel (MSB first),
+where bit i of an output word holds the state of pin i. Words are pin count bits wide and stored little endian,
+so byte k of a word holds pins 8k to 8k+7.
+**/
+
+namespace nled
+{
+	/**
+	@brief Available transpose kernels, ordered from slowest to fastest
+	**/
+	enum class TransposeKernel : int
+	{
+		Scalar	= 0,								//< Portable fallback
+		SSE2	= 1,								//< 16 bytes per iteration
+		AVX2	= 2,								//< 32 bytes per iteration
+		GFNI	= 3,								//< 64 bytes per iteration, requires AVX512BW and GFNI
+	};
+
+	/**
+	@brief Transposes inGroupCount groups of plane bytes in to inGroupCount groups of output words
+	**/
+	typedef void (*TransposeFunction)(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount);
+
+	/**
+	@brief Returns the fastest kernel supported by the cpu this process runs on, detected once
+	**/
+	TransposeKernel GetBestTransposeKernel();
+
+	/**
+	@brief Returns if the kernel is compiled in and supported by the cpu this process runs on
+	**/
+	bool IsTransposeKernelSupported(TransposeKernel inKernel);
+
+	/**
+	@brief Returns the transpose function for the given kernel and pin count (8, 16 or 32)
+
+	Falls back to scalar when the kernel isn't supported
+	**/
+	TransposeFunction GetTransposeFunction(TransposeKernel inKernel, int inPinCount);
+
+	/**
+	@brief Returns a human readable name for the kernel
+	**/
+	const char* GetTransposeKernelName(TransposeKernel inKernel);
+}
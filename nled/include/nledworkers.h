@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+@brief Shared pool of worker threads used to split work of a single device over multiple cores
+
+Work is submitted as a number of independent tasks, the calling thread helps out until all tasks are done.
+Multiple threads (one per device in EndDisplay) can submit work at the same time, tasks are picked up in submission order
+**/
+
+namespace nled
+{
+	/**
+	@brief Runs a single task, inIndex is in the range [0, task count)
+	**/
+	typedef void (*WorkerTask)(void* inContext, int inIndex);
+
+	/**
+	@brief Starts inThreadCount worker threads, stops the previous workers first
+	**/
+	void StartWorkers(int inThreadCount);
+
+	/**
+	@brief Stops all worker threads, waits for them to finish
+	**/
+	void StopWorkers();
+
+	/**
+	@brief Returns the amount of running worker threads
+	**/
+	int GetWorkerCount();
+
+	/**
+	@brief Runs inTaskCount tasks on the workers and the calling thread, returns when all tasks are done
+
+	Without workers all tasks are executed on the calling thread
+	**/
+	void RunTasks(WorkerTask inTask, void* inContext, int inTaskCount);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Standard Includes
+#include <chrono>
+
+/**
+@brief Event driven writer, a few threads write the frames of all devices instead of one transmit thread per device
+
+Every writer thread owns a set of devices and waits on their non blocking serial descriptors with epoll.
+A device is written as far as the serial driver accepts, the writer continues with it once the descriptor is writable again.
+Frames are handed over through the transmit state of the device (mTransmitData, mTransmitSize), the writer is woken with WakeWriter.
+Only available on linux, the devices keep their own transmit threads elsewhere
+**/
+
+struct NLedDevice;
+
+namespace nled
+{
+	/**
+	@brief Returns if the write of the frame handed to a device can start, otherwise sets outRetry to when to ask again
+
+	Called by the writer with the transmit lock of the device held
+	**/
+	typedef bool (*WriteReady)(NLedDevice* inDevice, std::chrono::steady_clock::time_point inNow, std::chrono::steady_clock::time_point& outRetry);
+
+	/**
+	@brief Called by the writer with the transmit lock of the device held, when the write of a frame starts, fails or finished
+	**/
+	typedef void (*WriteEvent)(NLedDevice* inDevice, std::chrono::steady_clock::time_point inNow);
+
+	/**
+	@brief Returns if the event driven writer is available on this platform
+	**/
+	bool IsWriterSupported();
+
+	/**
+	@brief Starts inThreadCount writer threads, stops the previous writers first. Returns false when not supported
+
+	inReady decides when a frame starts, inStarted and inFinished are called at the start and end of every write.
+	inFailed is called when the rest of a frame can't be written, inTimedOut when the serial driver didn't accept or drain any of it for inWriteTimeout.
+	The frame finishes after both
+	**/
+	bool StartWriters(int inThreadCount, std::chrono::milliseconds inWriteTimeout, WriteReady inReady, WriteEvent inStarted, WriteEvent inFinished, WriteEvent inFailed, WriteEvent inTimedOut);
+
+	/**
+	@brief Stops all writer threads, remove all devices first
+	**/
+	void StopWriters();
+
+	/**
+	@brief Returns the amount of running writer threads
+	**/
+	int GetWriterCount();
+
+	/**
+	@brief Hands the device to the writer with the least devices, the device needs to be open and idle
+	**/
+	bool AddWriterDevice(NLedDevice& ioDevice);
+
+	/**
+	@brief Takes the device away from it's writer, the device needs to be idle
+	**/
+	void RemoveWriterDevice(NLedDevice& ioDevice);
+
+	/**
+	@brief Hands the new descriptor of a reopened device to it's writer, the previous descriptor needs to be closed. Returns false when the device has no writer
+	**/
+	bool ResetWriterDevice(NLedDevice& ioDevice);
+
+	/**
+	@brief Wakes up the writer of a device after it's transmit state changed, does nothing when the device has no writer
+	**/
+	void WakeWriter(const NLedDevice& inDevice);
+}
@@ -71,8 +71,14 @@ public:
   bool
   isOpen () const;
 
+  int
+  getFileDescriptor () const;
+
   size_t
   available ();
+
+  size_t
+  outputQueued ();
   
   bool
   waitReadable (uint32_t timeout);
@@ -211,6 +211,15 @@ public:
   bool
   isOpen () const;
 
+  /*! Gets the native file descriptor of the serial port, used to drive
+   * the port from an external event loop (epoll, select).
+   *
+   * \return Returns the file descriptor, or -1 if the port is closed or
+   * the platform doesn't use file descriptors.
+   */
+  int
+  getFileDescriptor () const;
+
   /*! Closes the serial port. */
   void
   close ();
@@ -219,6 +228,10 @@ public:
   size_t
   available ();
 
+  /*! Return the number of written characters the driver didn't send yet. */
+  size_t
+  outputQueued ();
+
   /*! Block until there is serial data to read or read_timeout_constant
    * number of milliseconds have elapsed. The return value is true when
    * the function exits with the port in a readable state, false otherwise
@@ -723,6 +736,15 @@ struct PortInfo {
   /*! Hardware ID (e.g. VID:PID of USB serial devices) or "n/a" if not available. */
   std::string hardware_id;
 
+  /*! USB vendor id as hexadecimal string (e.g. "16c0"), empty if not available. */
+  std::string vendor_id;
+
+  /*! USB product id as hexadecimal string (e.g. "0483"), empty if not available. */
+  std::string product_id;
+
+  /*! USB serial number, empty if not available. */
+  std::string serial_number;
+
 };
 
 /* Lists the serial ports available on the system
@@ -6,34 +6,127 @@
 // Led devices
 #include <nleddevice.h>
 
+// Conversion
+#include <nledconversion.h>
+#include <nledtranspose.h>
+#include <nledworkers.h>
+
+// Output
+#include <nledwriter.h>
+#include <nledrealtime.h>
+#include <nledhotplug.h>
+
 // Standard Includes
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <sstream>
+#include <fstream>
 #include <chrono>      
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <assert.h>
-#include <thread>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
 
 // Namespace
 using namespace serial;
 using namespace std;
 
+/**
+@brief Configuration a device reports in it's handshake
+**/
+struct NLedDeviceConfig
+{
+	int				mUUID;									//< Unique identifier of device
+	int				mStripLength;							//< Amount of leds on one strip
+	int				mLedHeight;								//< Amount of leds in height
+	bool			mLayout;								//< Left to right / right to left
+	int				mPinCount;								//< Amount of parallel output pins
+};
+
+/**
+@brief Usb devices that are probed, 0 or an empty serial number matches any device
+**/
+struct NLedPortFilter
+{
+	int				mVendorId;								//< Usb vendor id
+	int				mProductId;								//< Usb product id
+	string			mSerialNumber;							//< Usb serial number
+};
+
+/**
+@brief Device the port watcher found on a new port, or a port that disappeared when there's no device
+**/
+struct NLedPortChange
+{
+	string			mPort;									//< Port that changed
+	NLedDevice*		mDevice;								//< Probed device, null when the port disappeared
+	bool			mCached;								//< If the device uses it's cached configuration
+};
+
 // Typedefs
 typedef map<int, NLedDevice*>	NLedDeviceMap;
+typedef map<string, NLedDeviceConfig>	NLedDeviceCache;	//< Configuration of usb devices by serial number
 
 //////////////////////////////////////////////////////////////////////////
 // Statics local to this module
 //////////////////////////////////////////////////////////////////////////
 const static int				sBautRate(9600);
+const static uint32_t			sSerialTimeout(1000);						//< Read and write timeout of the serial connection in milli seconds
+const static size_t				sMaxInfoSize(1024);							//< Longest info line accepted from a device
+static int						sHandshakeTimeout(1000);					//< Time in milli seconds every device gets to answer the interface query
+static vector<NLedPortFilter>	sPortFilters;								//< Usb devices that are probed, every port is probed without filters
+static string					sDeviceCachePath;							//< File the configuration of usb devices is cached in, empty disables the cache
 static NLedDeviceMap			sLedInterfaces;								//< Holds all the hardware interfaces
 static NLedDeviceMap			sDisplayToInterfaceMap;						//< Maps panel numbers to hardware interfaces
-
-const static int				sBytesPerLed(3);							//< Total amount of bytes per led
 static int*						sLedDisplayNumbers(nullptr);				//< Will hold a flat array of unique display id's
-static int*						sGammaTable(nullptr);						//< Will hold the gamma table
-const static int				sLedCharBufferOffset(3);					//< Holds the hardware device offset to color buffers
+static bool						sSkipUnchangedFrames(true);					//< If frames identical to the last one send are skipped
+static bool						sDropStaleFrames(false);					//< If frames wait for the previous one to drain, replaced by newer frames meanwhile
+const static chrono::milliseconds	sDrainPollTime(1);						//< Time between output queue checks while the previous frame drains
+static mutex					sOutputMutex;								//< Guards the amount of pending output tasks
+static condition_variable		sOutputDone;								//< Signaled when the last pending output task finished
+static int						sPendingOutputs(0);							//< Amount of devices that didn't finish their output task
+static int						sStreamChunkSize(0);						//< Size of the chunks frames are streamed in, 0 writes complete frames
+static float					sTargetFrameRate(30.0f);					//< Frame rate the sync pulse and frame pacing are based on
+static bool						sFramePacing(false);						//< If frame writes are spaced out at the target frame rate
+static nled::LateFramePolicy	sLateFramePolicy(nled::LateFramePolicy::Present);	//< What happens to frames that miss their tick
+static chrono::steady_clock::time_point	sLastFrameDue;						//< When the write of the last paced frame is due, unset when pacing restarts
+static chrono::steady_clock::time_point	sEndDisplayDue;						//< When the write of the frame converted by EndDisplay is due
+static int						sLateFrames(0);								//< Amount of frames that missed their tick since the last reset
+static int						sDroppedTicks(0);							//< Amount of ticks without a frame because of late frames
+static NLedDevice*				sSyncMaster(nullptr);						//< Device that sends the frame sync pulse to the slaves, null when every device syncs on it's own
+const static int				sSlaveWaitFrames(3);						//< Amount of frame times the master waits for the slaves to receive their frame
+const static int				sSkewFrameCount(8);							//< Amount of recent frames the start of write skew is measured for
+static mutex					sTimingMutex;								//< Guards the start of write skew measurements
+static unsigned long long		sSkewFrames[sSkewFrameCount];				//< Frame number of a skew measurement, 0 when unused
+static chrono::steady_clock::time_point	sSkewFirstStart[sSkewFrameCount];	//< First start of a write of the frame
+static chrono::steady_clock::time_point	sSkewLastStart[sSkewFrameCount];	//< Last start of a write of the frame
+static int						sSkewWrites[sSkewFrameCount];				//< Amount of devices that started writing the frame
+static double					sSkewSum(0.0);								//< Sum of the skew of all finished measurements in seconds
+static double					sMaxSkew(0.0);								//< Largest skew of all finished measurements in seconds
+static int						sSkewMeasurements(0);						//< Amount of finished measurements
+static unsigned long long		sSubmittedFrames(0);						//< Number of the last frame handed to the devices (EndDisplay, SubmitFrame or Blackout)
+static nled::OutputBackend		sOutputBackend(nled::OutputBackend::Threads);	//< How the converted frames are written to the devices
+static bool						sHotPlug(false);							//< If ports are watched for devices that connect or disconnect
+static bool						sDisplaysInitialized(false);				//< If InitDisplays ran, the port watcher only runs in between InitDisplays and ClearDisplays
+static mutex					sHotPlugMutex;								//< Guards the claimed ports and the port changes
+static set<string>				sClaimedPorts;								//< Ports of the devices in use or waiting to be added, they're never probed
+static vector<NLedPortChange>	sPortChanges;								//< Devices found and ports removed by the port watcher, applied by UpdateDisplays
+static nled::DisplayCallback	sDisplayCallback(nullptr);					//< Called by UpdateDisplays for every display that connected or disconnected
+static unsigned int				sDisplayGeneration(0);						//< Changes every time displays are added or removed
+const static chrono::milliseconds	sReconnectDelay(100);					//< Time before a device that went down is reopened, doubles with every failed attempt
+const static chrono::milliseconds	sMaxReconnectDelay(5000);				//< Longest time between attempts to reopen a device
+const static int				sMaxTimedOutWrites(2);						//< Amount of frames in a row that can time out before a device that stopped reading is taken down
+static thread					sReconnectThread;							//< Reopens the devices that went down, runs in between InitDisplays and ClearDisplays
+static mutex					sReconnectMutex;							//< Guards the reconnect schedule of the devices and the stop request
+static condition_variable		sReconnectSignal;							//< Signaled when a device went down or the reconnect thread needs to stop
+static bool						sStopReconnect(false);						//< Tells the reconnect thread to exit
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -41,9 +134,74 @@ const static int				sLedCharBufferOffset(3);					//< Holds the hardware device o
 //////////////////////////////////////////////////////////////////////////
 
 /**
-@brief Initializes (populates) a led device based on the received serial data
+@brief Reads from the device until a complete line arrived or the deadline passed, returns if the line is complete
+
+Every read waits for the first byte only, everything that arrived with it is read right away
+**/
+static bool ReadInfoLine(NLedDevice& inDevice, chrono::steady_clock::time_point inDeadline, string& outLine)
+{
+	unsigned char buffer[256];
+	while(outLine.find('\n') == string::npos)
+	{
+		long long remaining = chrono::duration_cast<chrono::milliseconds>(inDeadline - chrono::steady_clock::now()).count();
+		if(remaining <= 0 || outLine.size() > sMaxInfoSize)
+			return false;
+
+		Timeout timeout = Timeout::simpleTimeout((uint32_t)remaining);
+		inDevice.mConnection.setTimeout(timeout);
+		size_t count = inDevice.mConnection.read(buffer, 1);
+		size_t available = min(inDevice.mConnection.available(), sizeof(buffer) - count);
+		if(available > 0)
+			count += inDevice.mConnection.read(buffer + count, available);
+		outLine.append((const char*)buffer, count);
+	}
+	return true;
+}
+
+
+
+/**
+@brief Applies the configuration reported by a device and creates it's buffers, the device is valid afterwards
+**/
+static void ConfigureLedDevice(NLedDevice& inDevice, const NLedDeviceConfig& inConfig, const PortInfo& inPortInfo, ostream& outLog)
+{
+	inDevice.mLayout = inConfig.mLayout;
+	inDevice.mStripLength = inConfig.mStripLength;
+	inDevice.mLedHeight = inConfig.mLedHeight;
+	inDevice.mUUID = inConfig.mUUID;
+	inDevice.mDeviceName = "Interface" + to_string(inDevice.mUUID);
+	inDevice.mPanelUUIDOne = (inDevice.mUUID * 2) + 0;
+	inDevice.mPanelUUIDTwo = (inDevice.mUUID * 2) + 1;
+
+	// Amount of parallel outputs
+	inDevice.mPinCount = inConfig.mPinCount;
+	if(inDevice.mPinCount != 8 && inDevice.mPinCount != 16 && inDevice.mPinCount != 32)
+	{
+		outLog << "WARNING: Unsupported pin count: " << inDevice.mPinCount << " for device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << ", using 8\n";
+		inDevice.mPinCount = 8;
+	}
+
+	// Log warning regarding height being a multiple of the pin count
+	if(inDevice.mLedHeight % inDevice.mPinCount != 0)
+	{
+		assert(false);
+		outLog << "WARNING: Display height nog a multiple of " << inDevice.mPinCount << " for device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+	}
+
+	// Create the containers for the output buffer
+	nled::CreateConversionBuffers(inDevice);
+
+	inDevice.mValid = true;
+}
+
+
+
+/**
+@brief Opens a led device and reads the configuration it reports, the connection is closed again when that fails
+
+The device is queried right away, the answer is read as soon as it arrives, until inDeadline. Messages are written to outLog
 **/
-static bool InitLedDevice(NLedDevice& inDevice, const PortInfo& inPortInfo)
+static bool QueryLedDevice(NLedDevice& inDevice, const PortInfo& inPortInfo, chrono::steady_clock::time_point inDeadline, NLedDeviceConfig& outConfig, ostream& outLog)
 {
 	// Open connection
 	inDevice.mConnection.open();
@@ -51,501 +209,2595 @@ static bool InitLedDevice(NLedDevice& inDevice, const PortInfo& inPortInfo)
 	// Make sure the connection is valid
 	if(!inDevice.mConnection.isOpen())
 	{
-		cout << "ERROR: unable to open connection to port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+		outLog << "ERROR: unable to open connection to port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
 		return false;
 	}
 
+	chrono::steady_clock::time_point query_time = chrono::steady_clock::now();
 	if(!inDevice.mConnection.write(string("?")))
 	{
-		cout << "ERROR: unable to send interface query command to port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+		outLog << "ERROR: unable to send interface query command to port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
 		inDevice.mConnection.close();
 		return false;
 	}
 
-	// Wait before reading
-	this_thread::sleep_for(chrono::seconds(1));
+	// Read the info line as soon as it arrives, it can come in parts
+	string teensy_info;
+	bool complete = ReadInfoLine(inDevice, inDeadline, teensy_info);
+	inDevice.mHandshakeLatency = (float)chrono::duration<double, milli>(chrono::steady_clock::now() - query_time).count();
 
-	// Get info
-	unsigned char* teensy_info = new unsigned char[250];
-	inDevice.mConnection.read(teensy_info, 250);
-	vector<string> parsed_info;
+	// Restore the timeout used by the transmitter
+	Timeout timeout = Timeout::simpleTimeout(sSerialTimeout);
+	inDevice.mConnection.setTimeout(timeout);
+
+	if(!complete)
+	{
+		outLog << "ERROR: no led display layout configuration received within " << sHandshakeTimeout << " ms from device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+		inDevice.mConnection.close();
+		return false;
+	}
 
 	// Sample info
+	vector<string> parsed_info;
 	string temp_info;
-	for(int i=0; i < 250; i++)
+	for(char c : teensy_info)
 	{
-		if(teensy_info[i] == '\n') { break; }
+		if(c == '\n') { break; }
 
-		if(teensy_info[i] == ',')
+		if(c == ',')
 		{
 			parsed_info.push_back(temp_info);
 			temp_info.clear();
-			continue;;
+			continue;
 		}
 
-		temp_info += teensy_info[i];
+		temp_info += c;
 	}
 
-	// Validate received info (bit hacky)
-	if(parsed_info.size() == 0)
+	// Validate received info, the uuid is the 12th field
+	if(parsed_info.size() < 12)
 	{
-		cout << "ERROR: unable to read led display layout configuration for device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+		outLog << "ERROR: unable to read led display layout configuration for device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
 		inDevice.mConnection.close();
 		return false;
 	}
 
 	// Sample device settings
-	inDevice.mLayout = atoi(parsed_info[5].c_str()) == 0;
-	inDevice.mStripLength = atoi(parsed_info[0].c_str());
-	inDevice.mLedHeight = atoi(parsed_info[1].c_str());
-	inDevice.mUUID = atoi(parsed_info[11].c_str());
-	inDevice.mDeviceName = "Interface" + to_string(inDevice.mUUID);
-	inDevice.mPanelUUIDOne = (inDevice.mUUID * 2) + 0;
-	inDevice.mPanelUUIDTwo = (inDevice.mUUID * 2) + 1;
+	outConfig.mLayout = atoi(parsed_info[5].c_str()) == 0;
+	outConfig.mStripLength = atoi(parsed_info[0].c_str());
+	outConfig.mLedHeight = atoi(parsed_info[1].c_str());
+	outConfig.mUUID = atoi(parsed_info[11].c_str());
 
-	// Log warning regarding height being a multiple of 8
-	if(inDevice.mLedHeight % 8 != 0)
-	{
-		assert(false);
-		cout << "WARNING: Display height nog a multiple of 8 for device on port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
-	}
+	// Amount of parallel outputs, reported by newer controllers only
+	outConfig.mPinCount = parsed_info.size() > 12 ? atoi(parsed_info[12].c_str()) : 8;
+	return true;
+}
 
-	// Create the container for the output buffer
-	inDevice.mByteSize = (inDevice.mLedHeight * inDevice.mStripLength * sBytesPerLed) + sLedCharBufferOffset;
-	inDevice.mConvertedData = new unsigned char[inDevice.mByteSize];
 
-	delete[] teensy_info;
 
-	inDevice.mValid = true;
+/**
+@brief Initializes (populates) a led device based on the received serial data, queried until inDeadline
+**/
+static bool InitLedDevice(NLedDevice& inDevice, const PortInfo& inPortInfo, chrono::steady_clock::time_point inDeadline, ostream& outLog)
+{
+	NLedDeviceConfig config;
+	if(!QueryLedDevice(inDevice, inPortInfo, inDeadline, config, outLog))
+		return false;
+
+	ConfigureLedDevice(inDevice, config, inPortInfo, outLog);
 	return true;
 }
 
 
 
 /**
-@brief Converts a packed rgb color in to a led compatible data format
+@brief Initializes a usb device with the configuration it reported before, the device isn't queried
 **/
-static int GetColorWiring(int c) 
+static bool InitCachedLedDevice(NLedDevice& inDevice, const PortInfo& inPortInfo, const NLedDeviceConfig& inConfig, ostream& outLog)
 {
-	int red =	(c & 0xFF0000) >> 16;
-	int green = (c & 0x00FF00) >> 8;
-	int blue =	(c & 0x0000FF);
-	
-	red =	sGammaTable[red];
-	green = sGammaTable[green];
-	blue =	sGammaTable[blue];
+	// Open connection
+	inDevice.mConnection.open();
+
+	// Make sure the connection is valid
+	if(!inDevice.mConnection.isOpen())
+	{
+		outLog << "ERROR: unable to open connection to port: " << inPortInfo.port.c_str() << ", " << inPortInfo.description.c_str() << "\n";
+		return false;
+	}
 
-	return (green << 16) | (red << 8) | (blue);		// GRB - most common wiring
+	ConfigureLedDevice(inDevice, inConfig, inPortInfo, outLog);
+	return true;
 }
 
 
 
 /**
-@brief Converts the char data of every panel in to led led data streams
+@brief Returns if a port passes the port filters, ports without usb ids only pass when there are no filters
 **/
-void PixelsToLed(NLedDevice* inDevice)
+static bool MatchesPortFilters(const PortInfo& inPortInfo)
 {
-	int  width(inDevice->mStripLength);
-	int  height(inDevice->mLedHeight);
-	int  offset(sLedCharBufferOffset);
-	int  pixel[8];
-	bool layout(inDevice->mLayout);
-	int  strips_per_pin(height / 8);
+	if(sPortFilters.empty())
+		return true;
 
-	// Variables used in this loop
-	int x, y, xbegin, xend, xinc, mask;
+	if(inPortInfo.vendor_id.empty() || inPortInfo.product_id.empty())
+		return false;
+
+	int vendor_id = (int)strtol(inPortInfo.vendor_id.c_str(), nullptr, 16);
+	int product_id = (int)strtol(inPortInfo.product_id.c_str(), nullptr, 16);
+	for(const NLedPortFilter& filter : sPortFilters)
+	{
+		if(filter.mVendorId != 0 && filter.mVendorId != vendor_id)
+			continue;
+		if(filter.mProductId != 0 && filter.mProductId != product_id)
+			continue;
+		if(!filter.mSerialNumber.empty() && filter.mSerialNumber != inPortInfo.serial_number)
+			continue;
+		return true;
+	}
+	return false;
+}
 
-	// Holds the unsigned char data to be send over
-	unsigned char red(0);
-	unsigned char gre(0);
-	unsigned char blu(0);
 
-	// Where to sample from in the image
-	int image_index(-1);
 
-	// Calculate max index value
-	int  display_max_index = (inDevice->mStripLength * (inDevice->mLedHeight/2));
-	bool second_panel(false);
+/**
+@brief Reads the cached device configurations, one device per line: serial number, uuid, strip length, height, layout, pin count
+**/
+static NLedDeviceCache LoadDeviceCache()
+{
+	NLedDeviceCache cache;
+	if(sDeviceCachePath.empty())
+		return cache;
 
-	// For the amount of horizontal strips connected to a pin, iterate over every horizontal pixel
-	// Sample the color for that horizontal led on every pin (total number of 8)
-	for (y = 0; y < strips_per_pin; y++) 
+	ifstream file(sDeviceCachePath.c_str());
+	string line;
+	while(getline(file, line))
 	{
-		if ((y & 1) == (layout ? 0 : 1)) 
-		{
-			// even numbered rows are left to right
-			xbegin = 0;
-			xend = width;
-			xinc = 1;
-		} 
-		else 
-		{
-			// odd numbered rows are right to left
-			xbegin = width - 1;
-			xend = -1;
-			xinc = -1;
-		}
+		istringstream fields(line);
+		string serial_number;
+		NLedDeviceConfig config;
+		if(fields >> serial_number >> config.mUUID >> config.mStripLength >> config.mLedHeight >> config.mLayout >> config.mPinCount)
+			cache[serial_number] = config;
+	}
+	return cache;
+}
 
-		// Iterate over every horizontal pixel per strip and convert color data
-		for (x = xbegin; x != xend; x += xinc) 
-		{
-			for (int i=0; i < 8; i++) 
-			{
-				// Calculate image lookup index and sample color values
-				image_index = x + (y + strips_per_pin * i) * width;
-				unsigned char* image_data = image_index < display_max_index ?  inDevice->mRGBDataPanelOne : inDevice->mRGBDataPanelTwo;  
-				
-				// Remap image index based on sample display
-				image_index = image_index % display_max_index;
-				
-				red = image_data[(image_index * sBytesPerLed) + 0]; 
-				gre = image_data[(image_index * sBytesPerLed) + 1];
-				blu = image_data[(image_index * sBytesPerLed) + 2];
-
-				// Combine in to int and get correct led data set
-				pixel[i] = red << 16|gre << 8|blu << 0;
-
-				// Sample to int and update color wiring
-				pixel[i] = red<<16|gre<<8|blu<<0;
-				pixel[i] = GetColorWiring(pixel[i]);
-			}
 
-			// convert 8 pixels to 24 bytes (some black magic here)
-			for (mask = 0x800000; mask != 0; mask >>= 1) 
-			{
-				unsigned char b = 0;
-				for (int i=0; i < 8; i++) 
-				{
-					if ((pixel[i] & mask) != 0) b |= (1 << i);
-				}
 
-				inDevice->mConvertedData[offset++] = b;
-			}
-		}
-	}
+/**
+@brief Writes the cached device configurations, see LoadDeviceCache
+**/
+static void SaveDeviceCache(const NLedDeviceCache& inCache)
+{
+	ofstream file(sDeviceCachePath.c_str(), ios::trunc);
+	for(const auto& v : inCache)
+		file << v.first << " " << v.second.mUUID << " " << v.second.mStripLength << " " << v.second.mLedHeight << " " << v.second.mLayout << " " << v.second.mPinCount << "\n";
 
-	// Fill first 3 bytes with sync info
-	inDevice->mConvertedData[0] = '*';							// first device is the frame sync master
-	int usec = (int)((1000000.0 / 30) * 0.75);
-	inDevice->mConvertedData[1] = (unsigned char)(usec);		// request the frame sync pulse
-	inDevice->mConvertedData[2] = (unsigned char)(usec >> 8);	// at 75% of the frame time
+	if(!file)
+		cout << "WARNING: unable to write led device cache: " << sDeviceCachePath << "\n";
 }
 
 
 
 /**
-@brief Thread safe method to convert and transfer pixel data to hardware device
+@brief Probes a single port on it's own thread, errors of the serial connection invalidate the device
+
+Devices with a cached configuration (inCached) are only opened
 **/
-void FlushToDevice(NLedDevice* inDevice)
+static void ProbeLedDevice(NLedDevice* ioDevice, const PortInfo* inPortInfo, const NLedDeviceConfig* inCached, chrono::steady_clock::time_point inDeadline, ostringstream* outLog)
 {
-	PixelsToLed(inDevice);
-	inDevice->mConnection.write(inDevice->mConvertedData, inDevice->mByteSize);
+	try
+	{
+		if(inCached != nullptr)
+			InitCachedLedDevice(*ioDevice, *inPortInfo, *inCached, *outLog);
+		else
+			InitLedDevice(*ioDevice, *inPortInfo, inDeadline, *outLog);
+	}
+	catch(const exception& e)
+	{
+		*outLog << "ERROR: unable to initialize led device on port: " << inPortInfo->port.c_str() << ", " << e.what() << "\n";
+		ioDevice->mValid = false;
+	}
 }
 
 
 
 /**
-@brief Finds the led device for the given display number
+@brief Probes all ports at once, every device gets the same time to answer. Usb devices in the cache aren't queried
+
+Every port gets a device, only the valid ones are open. Messages are written to the log of the port
 **/
-static NLedDevice* FindLedDevice(int inDisplayNumber)
+static void ProbePorts(const vector<PortInfo>& inPorts, const NLedDeviceCache& inCache, vector<NLedDevice*>& outDevices, vector<bool>& outCached, vector<ostringstream>& outLogs)
 {
-	// Find in map
-	NLedDeviceMap::iterator it = sDisplayToInterfaceMap.find(inDisplayNumber);
-	
-	// Return pointer or null
-	return it == sDisplayToInterfaceMap.end() ? nullptr : it->second;
+	outDevices.resize(inPorts.size());
+	outCached.assign(inPorts.size(), false);
+	outLogs.resize(inPorts.size());
+
+	vector<thread> probes;
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(sHandshakeTimeout);
+	for(size_t i=0; i < inPorts.size(); i++)
+	{
+		NLedDeviceCache::const_iterator cached = inCache.find(inPorts[i].serial_number);
+		const NLedDeviceConfig* config = !inPorts[i].serial_number.empty() && cached != inCache.end() ? &cached->second : nullptr;
+		outCached[i] = config != nullptr;
+
+		outDevices[i] = new NLedDevice(inPorts[i]);
+		probes.push_back(thread(ProbeLedDevice, outDevices[i], &inPorts[i], config, deadline, &outLogs[i]));
+	}
+	for(thread& probe : probes)
+		probe.join();
 }
 
 
 
 /**
-@brief Initialize all the available displays
+@brief Closes the connection of a device that isn't in use and deletes it
 **/
-void nled::InitDisplays(float inGammaValue)
+static void DeleteLedDevice(NLedDevice* ioDevice)
 {
-	// Clear all existing led devices
-	sLedInterfaces.clear();
-	sDisplayToInterfaceMap.clear();
+	if(ioDevice->mConnection.isOpen())
+		ioDevice->mConnection.close();
+	nled::DeleteConversionBuffers(*ioDevice);
+	delete ioDevice;
+}
 
-	// Cycle over all avaialble devices and add valid interfaces
-	vector<PortInfo> found_devices = serial::list_ports();
-	for(const PortInfo& p : found_devices)
-	{
-		// Create a new led communication device 
-		NLedDevice* new_led_device = new NLedDevice(p);
-		
-		// Initialize the device based on the current port
-		InitLedDevice(*new_led_device, p);
 
-		// Make sure the device is valid (initialized and open)
-		if(!new_led_device->mValid)
-		{
-			delete new_led_device;
-			continue;
-		}
 
-		// Make sure the id is unique for the device and displays attached to device
-		assert(sLedInterfaces.find(new_led_device->mUUID) == sLedInterfaces.end());
-		assert(sDisplayToInterfaceMap.find(new_led_device->mPanelUUIDOne) == sDisplayToInterfaceMap.end());
-		assert(sDisplayToInterfaceMap.find(new_led_device->mPanelUUIDTwo) == sDisplayToInterfaceMap.end());
+/**
+@brief Returns when the write of the next frame is due, frames are spaced out at the target frame rate when pacing is enabled
 
-		// Store results local to module (for fast access later on)
-		sLedInterfaces[new_led_device->mUUID] = new_led_device;
-		sDisplayToInterfaceMap[new_led_device->mPanelUUIDOne] = new_led_device;
-		sDisplayToInterfaceMap[new_led_device->mPanelUUIDTwo] = new_led_device;
+A frame that's handed over after its tick is late. It's either written right away and the clock restarts from it,
+or it's written at the next tick and the ticks in between are dropped
+**/
+static chrono::steady_clock::time_point ScheduleFrame()
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if(!sFramePacing)
+		return now;
 
-		cout << "Added led interface on port: " << p.port << ", " << p.description << ", device id: "<< new_led_device->mUUID <<", width: " << new_led_device->mStripLength << ", height: " << new_led_device->mLedHeight << "\n";
+	// The first frame starts the clock
+	if(sLastFrameDue == chrono::steady_clock::time_point())
+	{
+		sLastFrameDue = now;
+		return now;
 	}
 
-	// Signal success
-	std::cout << "Found: " << sLedInterfaces.size() << " valid LED interfaces\n";
+	chrono::steady_clock::duration period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / sTargetFrameRate));
+	chrono::steady_clock::time_point due = sLastFrameDue + period;
+	if(due < now)
+	{
+		sLateFrames++;
+		if(sLateFramePolicy == nled::LateFramePolicy::Present)
+		{
+			due = now;
+		}
+		else
+		{
+			int missed_ticks = (int)((now - due) / period) + 1;
+			due += period * missed_ticks;
+			sDroppedTicks += missed_ticks;
+		}
+	}
 
-	// Create gamma table
-	sGammaTable = new int[256];
-	for(int i=0; i<256; i++)
-		sGammaTable[i] = (int)(pow((float)i / 255.0, inGammaValue) * 255.0f + 0.5);
+	sLastFrameDue = due;
+	return due;
 }
 
 
 
 /**
-@brief Closes all serial connections and clears display buffers
+@brief Records the start of a write, call with the transmit lock of the device held
 **/
-void nled::ClearDisplays()
+static void RecordWriteStart(NLedDevice* inDevice, chrono::steady_clock::time_point inStart)
 {
-	for(auto& v : sLedInterfaces)
+	if(inDevice->mLastWriteStart != chrono::steady_clock::time_point())
 	{
-		// Close serial connection
-		v.second->mConnection.close();
-		
-		// Delete data buffer
-		delete[] v.second->mConvertedData;
+		double interval = chrono::duration<double>(inStart - inDevice->mLastWriteStart).count();
+		inDevice->mTimedFrames++;
+		inDevice->mIntervalSum += interval;
+		inDevice->mIntervalSquareSum += interval * interval;
 	}
+	inDevice->mLastWriteStart = inStart;
+}
 
-	// Clear interfaces
-	sLedInterfaces.clear();
 
-	// Clear sampled display numbers
-	if(sLedDisplayNumbers != nullptr)
-		delete[] sLedDisplayNumbers;
 
-	// Delete gamma table
-	delete[] sGammaTable;
+/**
+@brief Adds the skew of a frame measurement to the totals and clears it, call with sTimingMutex locked
+**/
+static void FinishSkewMeasurement(int inIndex)
+{
+	if(sSkewWrites[inIndex] > 1)
+	{
+		double skew = chrono::duration<double>(sSkewLastStart[inIndex] - sSkewFirstStart[inIndex]).count();
+		sSkewSum += skew;
+		sMaxSkew = skew > sMaxSkew ? skew : sMaxSkew;
+		sSkewMeasurements++;
+	}
+	sSkewFrames[inIndex] = 0;
+	sSkewWrites[inIndex] = 0;
 }
 
 
 
 /**
-@brief Returns if a display exists or not
+@brief Records the start of a write of a frame, the skew of a frame is the time between the first and the last device starting it
+
+The measurement of the frame stored in the same spot, sSkewFrameCount frames earlier, is finished first
 **/
-bool nled::DisplayExists(int inDisplayNumber)
+static void RecordFrameStart(unsigned long long inFrame, chrono::steady_clock::time_point inStart)
 {
-	int* displays = GetAvailableDisplayNumbers();
-	for(int i=0; i < GetDisplayCount(); i++)
+	lock_guard<mutex> lock(sTimingMutex);
+	int index = (int)(inFrame % sSkewFrameCount);
+	if(sSkewFrames[index] != inFrame)
 	{
-		if(displays[i] == inDisplayNumber)
-			return true;
+		FinishSkewMeasurement(index);
+		sSkewFrames[index] = inFrame;
+		sSkewFirstStart[index] = inStart;
+		sSkewLastStart[index] = inStart;
 	}
-	return false;
+
+	sSkewFirstStart[index] = inStart < sSkewFirstStart[index] ? inStart : sSkewFirstStart[index];
+	sSkewLastStart[index] = inStart > sSkewLastStart[index] ? inStart : sSkewLastStart[index];
+	sSkewWrites[index]++;
 }
 
 
 
 /**
-@brief Returns all the available led displays
+@brief Returns if a frame identical to the last one written can be skipped
+
+The frame sync master is written every frame, the slaves show their frame on it's sync pulse
 **/
-int nled::GetDisplayCount()
+static bool CanSkipFrame(const NLedDevice* inDevice)
 {
-	return sLedInterfaces.size() * 2;
+	return sSkipUnchangedFrames && inDevice->mSentValid && inDevice != sSyncMaster;
 }
 
 
+
 /**
-@brief Returns all the available unique display numbers
+@brief Returns if every frame sync slave received the frame, or skipped it, call with sOutputMutex locked
 **/
-int* nled::GetAvailableDisplayNumbers()
+static bool SlavesReceived(unsigned long long inFrame)
 {
-	if(sLedDisplayNumbers == nullptr)
+	for(auto& v : sLedInterfaces)
 	{
-		sLedDisplayNumbers = GetDisplayCount() > 0 ? new int[GetDisplayCount()] : nullptr;
-		
-		int count(0);
-		for(auto v : sLedInterfaces)
-		{
-			NLedDevice* current_dev = v.second;
-			sLedDisplayNumbers[(count * 2) + 0] = v.second->mPanelUUIDOne;
-			sLedDisplayNumbers[(count * 2) + 1] = v.second->mPanelUUIDTwo;
-			count++;
-		}
+		if(v.second->mSyncSlave && v.second->mPresentedFrame < inFrame)
+			return false;
 	}
-
-	return sLedDisplayNumbers;
+	return true;
 }
 
 
 
 /**
-@brief Returns the display size for the given display number
+@brief Returns how long the master waits for the slaves to receive their frame
 **/
-int nled::GetDisplaySize(int inDisplayNumber)
+static chrono::steady_clock::duration GetSlaveWaitTime()
 {
-	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
-
-	// Make sure the device was found
-	assert(found_device);
-
-	// Return the info
-	return found_device == nullptr ? -1 : (found_device->mLedHeight / 2) * found_device->mStripLength;
+	return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(sSlaveWaitFrames / sTargetFrameRate));
 }
 
 
+
 /**
-@brief Returns the total amount of bytes for a display
+@brief Waits until every frame sync slave received the frame, or skipped it, before the master triggers them
+
+Gives up after a couple of frame times, slaves show their frame on their own when the sync pulse doesn't come
 **/
-int nled::GetDisplayByteSize(int inDisplayNumber)
+static void WaitForSlaves(unsigned long long inFrame)
 {
-	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
-
-	// Make sure the device was found
-	assert(found_device);
-
-	// Return info
-	return found_device == nullptr ? -1 : (found_device->mLedHeight / 2) * found_device->mStripLength * GetBytesPerLed();
+	unique_lock<mutex> lock(sOutputMutex);
+	sOutputDone.wait_for(lock, GetSlaveWaitTime(), [inFrame] { return SlavesReceived(inFrame); });
 }
 
 
 
 /**
-@brief Returns the max number of bytes relative to the biggest available display
+@brief Marks a frame as presented and wakes up the threads waiting for it, call with the transmit lock of the device held
 **/
-int nled::GetMaxDisplayByteSize()
+static void PresentFrame(NLedDevice* inDevice, unsigned long long inFrame)
 {
-	int max_size(-1);
-	for(int i=0; i< GetDisplayCount(); i++)
+	inDevice->mPresentedFrame = inFrame;
 	{
-		int s = GetDisplayByteSize(GetAvailableDisplayNumbers()[i]);
-		max_size = s > max_size ? s : max_size;
+		lock_guard<mutex> output_lock(sOutputMutex);
 	}
-	return max_size;
+	sOutputDone.notify_all();
 }
 
 
 
 /**
-@brief Returns amount of bytes per led (3 -> RGB)
+@brief Waits until the transmit thread of a device finished writing the previous frame, returns with the transmit lock held
+
+When stale frames are dropped a frame that's still waiting for it's write to start can be replaced right away
 **/
-int nled::GetBytesPerLed()
+static unique_lock<mutex> WaitForTransmit(NLedDevice* inDevice)
 {
-	return sBytesPerLed;
+	unique_lock<mutex> lock(inDevice->mTransmitMutex);
+	inDevice->mTransmitSignal.wait(lock, [inDevice] { return inDevice->mTransmitData == nullptr || (sDropStaleFrames && !inDevice->mTransmitStarted); });
+	return lock;
 }
 
 
 
-
 /**
-@brief Returns the stride (amount of leds on a single connected strip)
+@brief Hands a frame to the idle transmit thread of a device, ioLock is the lock returned by WaitForTransmit
+
+The first inSize bytes can be written right away, the rest follows with ExtendTransmit.
+A frame that didn't start yet is dropped, it's presented with the frame that replaces it.
+Frames for a device that's down are presented right away, the rest of a streamed frame is ignored
 **/
-int nled::GetDisplayStride(int inDisplayNumber)
+static void StartTransmit(NLedDevice* inDevice, unique_lock<mutex>& ioLock, const unsigned char* inData, int inSize, unsigned long long inFrame, chrono::steady_clock::time_point inDue)
 {
-	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+	// Nothing is written while the device is down, the frame counts as presented
+	if(!inDevice->mOnline)
+	{
+		inDevice->mLostFrames++;
+		PresentFrame(inDevice, inFrame);
+		ioLock.unlock();
+		return;
+	}
 
-	// Make sure the device was found
-	assert(found_device);
+	if(inDevice->mTransmitData != nullptr)
+		inDevice->mDroppedFrames++;
 
-	return found_device == nullptr ? -1 : found_device->mStripLength;
+	inDevice->mTransmitData = inData;
+	inDevice->mTransmitSize = inSize;
+	inDevice->mTransmitFrame = inFrame;
+	inDevice->mTransmitDue = inDue;
+	ioLock.unlock();
+	inDevice->mTransmitSignal.notify_all();
+	nled::WakeWriter(*inDevice);
 }
 
 
 
 /**
-@brief Returns the height of the display
+@brief Allows the transmit thread to write the first inSize bytes of the frame that's being streamed
 **/
-int nled::GetDisplayHeight(int inDisplayNumber)
+static void ExtendTransmit(NLedDevice* inDevice, int inSize)
 {
-	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
-
-	// Make sure the device was found
-	assert(found_device);
-
-	return found_device == nullptr ? -1 : found_device->mLedHeight / 2;
+	{
+		lock_guard<mutex> lock(inDevice->mTransmitMutex);
+		inDevice->mTransmitSize = inSize;
+	}
+	inDevice->mTransmitSignal.notify_all();
+	nled::WakeWriter(*inDevice);
 }
 
 
 
 /**
-@brief Returns the total amount of pixels of all displays combined
+@brief Returns if the previous frame left the serial driver, always true when stale frames aren't dropped
 **/
-int nled::GetTotalDisplaySize()
+static bool IsOutputDrained(NLedDevice* inDevice)
 {
-	int total_count(0);
-	for(auto v : sLedInterfaces)
-		total_count += (v.second->mLedHeight * v.second->mStripLength);
-	return total_count;
+	// A connection that failed is drained, the write that follows fails as well
+	try
+	{
+		return !sDropStaleFrames || inDevice->mConnection.outputQueued() == 0;
+	}
+	catch(const exception&)
+	{
+		return true;
+	}
 }
 
 
 
 /**
-@brief Returns the total byte size for all displays
+@brief Counts a frame that couldn't be written completely, call with the transmit lock of the device held
+
+The device shows an unknown frame, the next frame is written even when it didn't change
 **/
-int nled::GetTotalDisplayByteSize()
+static void FailTransmit(NLedDevice* inDevice)
 {
-	return GetTotalDisplaySize() * sBytesPerLed;
+	inDevice->mPartialFrames++;
+	inDevice->mSentValid = false;
+	inDevice->mTransmitFailed = true;
 }
 
 
 
 /**
-@brief Sets the data for an individual led panel
+@brief Stops writing to a device of which the connection failed, call with the transmit lock of the device held
+
+The other devices keep going, the reconnect thread reopens the device after a while
 **/
-void nled::SetData(int inDisplayIndex, unsigned char* inData)
+static void SetDeviceDown(NLedDevice* inDevice)
 {
-	// Find the right device to set the data for
-	NLedDevice* found_device = FindLedDevice(inDisplayIndex);
-	
-	// Make sure it's valid
-	assert(found_device != nullptr);
-	if(found_device == nullptr)
+	inDevice->mErrorCount++;
+	inDevice->mTimedOutWrites = 0;
+	{
+		lock_guard<mutex> lock(sReconnectMutex);
+		inDevice->mOnline = false;
+		inDevice->mReconnectAttempts = 0;
+		inDevice->mReconnectDue = chrono::steady_clock::now() + sReconnectDelay;
+	}
+	sReconnectSignal.notify_all();
+}
+
+
+
+/**
+@brief Counts a frame of which the write timed out, call with the transmit lock of the device held
+
+A device that keeps timing out stopped reading, it's taken down so frames don't wait for it
+**/
+static void TimeOutTransmit(NLedDevice* inDevice)
+{
+	FailTransmit(inDevice);
+	if(++inDevice->mTimedOutWrites < sMaxTimedOutWrites)
 		return;
 
-	// Point panel to right data
-	if(found_device->mPanelUUIDOne == inDisplayIndex)
-		found_device->mRGBDataPanelOne = inData;
+	cout << "ERROR: led device on port: " << inDevice->mPortInfo.port << " stopped reading, " << inDevice->mTimedOutWrites << " writes in a row timed out\n";
+	SetDeviceDown(inDevice);
+}
+
+
+
+/**
+@brief Marks the frame handed to a device as written, call with the transmit lock of the device held
+
+Frames skipped during the write are presented with it. The master is woken up when the last slave received it's frame.
+A frame that's written completely ends a series of timed out writes
+**/
+static void FinishTransmit(NLedDevice* inDevice)
+{
+	if(!inDevice->mTransmitFailed)
+		inDevice->mTimedOutWrites = 0;
+	inDevice->mTransmitFailed = false;
+	inDevice->mTransmitData = nullptr;
+	inDevice->mTransmitStarted = false;
+	PresentFrame(inDevice, inDevice->mTransmitFrame);
+	inDevice->mTransmitSignal.notify_all();
+	if(inDevice->mSyncSlave && sSyncMaster != nullptr)
+		nled::WakeWriter(*sSyncMaster);
+}
+
+
+
+/**
+@brief Presents a frame that isn't written because it didn't change
+
+Presented right away, or by the transmit thread after the write of the previous frame
+**/
+static void SkipFrame(NLedDevice* inDevice, unsigned long long inFrame)
+{
+	lock_guard<mutex> lock(inDevice->mTransmitMutex);
+	inDevice->mSkippedFrames++;
+	if(inDevice->mTransmitData != nullptr)
+		inDevice->mTransmitFrame = inFrame;
 	else
-		found_device->mRGBDataPanelTwo = inData;
+		PresentFrame(inDevice, inFrame);
 }
 
 
 
 /**
-@brief Returns the data pointer for the individual led display
+@brief State of a frame that's streamed to a device while it converts
 **/
-unsigned char* nled::GetData(int inDisplayIndex)
+struct NLedStream
 {
-	NLedDevice* found_device = FindLedDevice(inDisplayIndex);
-	assert(found_device != nullptr);
-	
-	return found_device->mPanelUUIDOne == inDisplayIndex ? found_device->mRGBDataPanelOne : found_device->mRGBDataPanelTwo;
+	unsigned long long	mFrame;									//< Number of the frame
+	chrono::steady_clock::time_point mDue;						//< When the write of the frame is due
+	int					mCopied;								//< Amount of bytes copied to the transmit buffer, or identical to it
+	bool				mStarted;								//< If the frame is handed to the transmit thread
+};
+
+
+
+/**
+@brief Hands a converted chunk to the transmit thread
+
+Chunks identical to the last frame send are held back, the frame is skipped when all of them are.
+The first chunk that differs waits for the previous write to finish and starts the transmission
+**/
+static void StreamChunk(NLedDevice* inDevice, int inByteCount, bool inConverted, void* inContext)
+{
+	NLedStream& stream = *(NLedStream*)inContext;
+	int offset = stream.mCopied;
+	int size = inByteCount - offset;
+	stream.mCopied = inByteCount;
+
+	if(stream.mStarted)
+	{
+		memcpy(inDevice->mSentData + offset, inDevice->mConvertedData + offset, size);
+		ExtendTransmit(inDevice, inByteCount);
+		return;
+	}
+
+	if(CanSkipFrame(inDevice))
+	{
+		if(!inConverted || memcmp(inDevice->mSentData + offset, inDevice->mConvertedData + offset, size) == 0)
+			return;
+	}
+
+	unique_lock<mutex> lock = WaitForTransmit(inDevice);
+	memcpy(inDevice->mSentData + offset, inDevice->mConvertedData + offset, size);
+	inDevice->mSentValid = true;
+	stream.mStarted = true;
+	StartTransmit(inDevice, lock, inDevice->mSentData, inByteCount, stream.mFrame, stream.mDue);
 }
 
 
 
 /**
-@brief Converts and sends the data in the display buffers to the various devices
+@brief Thread safe method to convert and transfer pixel data to hardware device
 
-Note that this method rund parallel for every device and syncs up before returning
+Frames identical to the last one written are skipped. When no strip row was converted the frame is known to be unchanged,
+otherwise it is compared against a copy of the last frame send.
+The converted frame is copied to the transmit buffer once the previous write finished, the transmit thread writes it
+while the next frame is converted
 **/
-void nled::EndDisplay()
+static void FlushToDevice(NLedDevice* inDevice, unsigned long long inFrame, chrono::steady_clock::time_point inDue)
 {
-	// Create container that will hold threads
-	vector<thread> conversion_threads;
-	conversion_threads.reserve(sLedInterfaces.size());
+	// Stream the frame in chunks while it converts
+	if(sStreamChunkSize > 0)
+	{
+		NLedStream stream = { inFrame, inDue, 0, false };
+		PixelsToLed(inDevice, nled::GetConversionEngine(), sStreamChunkSize, StreamChunk, &stream);
+		if(!stream.mStarted)
+			SkipFrame(inDevice, inFrame);
+		return;
+	}
 
-	// Start threaded conversion and uploading
-	for(auto v : sLedInterfaces)
-		conversion_threads.push_back(thread(FlushToDevice, v.second));
+	bool converted = PixelsToLed(inDevice);
+	if(CanSkipFrame(inDevice))
+	{
+		if(!converted || memcmp(inDevice->mSentData, inDevice->mConvertedData, inDevice->mByteSize) == 0)
+		{
+			SkipFrame(inDevice, inFrame);
+			return;
+		}
+	}
+
+	unique_lock<mutex> lock = WaitForTransmit(inDevice);
+	memcpy(inDevice->mSentData, inDevice->mConvertedData, inDevice->mByteSize);
+	inDevice->mSentValid = true;
+	StartTransmit(inDevice, lock, inDevice->mSentData, inDevice->mByteSize, inFrame, inDue);
+}
+
+
+
+/**
+@brief Converts and transfers the user data of a device, the frame number and due time are set by EndDisplay
+**/
+static void FlushUserDataToDevice(NLedDevice* inDevice)
+{
+	FlushToDevice(inDevice, sSubmittedFrames, sEndDisplayDue);
+}
+
+
+
+/**
+@brief Thread safe method to transfer the precomputed all black frame to hardware device
+**/
+static void BlackoutDevice(NLedDevice* inDevice)
+{
+	unique_lock<mutex> lock = WaitForTransmit(inDevice);
+	nled::WriteSyncHeader(*inDevice, inDevice->mBlackData);
+	inDevice->mSentValid = false;
+	StartTransmit(inDevice, lock, inDevice->mBlackData, inDevice->mByteSize, sSubmittedFrames, chrono::steady_clock::now());
+}
+
+
+
+/**
+@brief Converts and sends the frame submitted to a slot, the slot is read only while doing so
+**/
+static void FlushFrameToDevice(NLedDevice* inDevice, int inSlot)
+{
+	int panel_size = (inDevice->mLedHeight / 2) * inDevice->mStripLength * inDevice->mDisplayBytesPerLed;
+	inDevice->mRGBDataPanelOne = inDevice->mFrameData[inSlot];
+	inDevice->mRGBDataPanelTwo = inDevice->mFrameData[inSlot] + panel_size;
+	nled::ApplyRowFlags(*inDevice, inDevice->mFrameRows[inSlot]);
+	FlushToDevice(inDevice, inDevice->mFrameNumbers[inSlot], inDevice->mFrameDue[inSlot]);
+}
+
+
+
+/**
+@brief Output thread of a device, sleeps until a task is handed to it or a frame is submitted
+
+Submitted frames are converted in order, every converted frame frees up a slot for the next one
+**/
+static void RunOutputThread(NLedDevice* inDevice)
+{
+	unique_lock<mutex> lock(inDevice->mOutputMutex);
+	while(true)
+	{
+		inDevice->mOutputSignal.wait(lock, [inDevice] { return inDevice->mOutputTask != nullptr || inDevice->mQueuedFrames > 0 || inDevice->mStopOutput; });
+		if(inDevice->mStopOutput)
+			return;
+
+		// Convert the oldest submitted frame
+		if(inDevice->mOutputTask == nullptr)
+		{
+			int slot = inDevice->mOutputSlot;
+			lock.unlock();
+			FlushFrameToDevice(inDevice, slot);
+			lock.lock();
+
+			inDevice->mOutputSlot = (slot + 1) % sFrameSlotCount;
+			inDevice->mQueuedFrames--;
+			{
+				lock_guard<mutex> output_lock(sOutputMutex);
+			}
+			sOutputDone.notify_all();
+			continue;
+		}
+
+		NLedOutputTask task = inDevice->mOutputTask;
+		lock.unlock();
+		task(inDevice);
+		lock.lock();
+		inDevice->mOutputTask = nullptr;
+
+		// Wake up the caller when this was the last device
+		lock_guard<mutex> output_lock(sOutputMutex);
+		if(--sPendingOutputs == 0)
+			sOutputDone.notify_all();
+	}
+}
+
+
+
+/**
+@brief Writes to the connection of a device, returns the amount of bytes written or -1 when the connection failed
+**/
+static int WriteToDevice(NLedDevice* inDevice, const unsigned char* inData, int inSize)
+{
+	try
+	{
+		return (int)inDevice->mConnection.write(inData, inSize);
+	}
+	catch(const exception& e)
+	{
+		cout << "ERROR: unable to write to led device on port: " << inDevice->mPortInfo.port << ", " << e.what() << "\n";
+		return -1;
+	}
+}
+
+
+
+/**
+@brief Waits for the frame written to a device to leave the serial driver, for the serial timeout at most
+
+Returns 1 when it left, 0 when the device didn't read it in time and -1 when the connection failed
+**/
+static int DrainDevice(NLedDevice* inDevice)
+{
+	chrono::steady_clock::time_point give_up = chrono::steady_clock::now() + chrono::milliseconds(sSerialTimeout);
+	try
+	{
+		while(inDevice->mConnection.outputQueued() > 0)
+		{
+			if(chrono::steady_clock::now() >= give_up)
+			{
+				cout << "ERROR: write to led device on port: " << inDevice->mPortInfo.port << " timed out\n";
+				return 0;
+			}
+			this_thread::sleep_for(sDrainPollTime);
+		}
+		return 1;
+	}
+	catch(const exception& e)
+	{
+		cout << "ERROR: unable to flush led device on port: " << inDevice->mPortInfo.port << ", " << e.what() << "\n";
+		return -1;
+	}
+}
+
+
+
+/**
+@brief Transmit thread of a device, writes the frames handed to it by the output thread
+
+A streamed frame is written in parts, every part is written as soon as it's converted.
+A connection that fails, or writes that keep timing out, take the device down. The frame is finished and the thread waits for the next one
+**/
+static void RunTransmitThread(NLedDevice* inDevice)
+{
+	unique_lock<mutex> lock(inDevice->mTransmitMutex);
+	while(true)
+	{
+		inDevice->mTransmitSignal.wait(lock, [inDevice] { return inDevice->mTransmitData != nullptr || inDevice->mStopTransmit; });
+		if(inDevice->mTransmitData == nullptr)
+			return;
+
+		// Wait for the tick of the frame and for the previous frame to drain, a newer frame can replace it meanwhile
+		chrono::steady_clock::time_point due = inDevice->mTransmitDue;
+		if(due > chrono::steady_clock::now())
+		{
+			inDevice->mTransmitSignal.wait_until(lock, due);
+			continue;
+		}
+		if(!IsOutputDrained(inDevice))
+		{
+			inDevice->mTransmitSignal.wait_for(lock, sDrainPollTime);
+			continue;
+		}
+
+		// Frames skipped from now on change the frame number that's presented, not the one that's written
+		// The master waits for the slaves to be primed as well
+		inDevice->mTransmitStarted = true;
+		unsigned long long frame = inDevice->mTransmitFrame;
+		if(inDevice == sSyncMaster)
+		{
+			lock.unlock();
+			WaitForSlaves(frame);
+			lock.lock();
+		}
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		inDevice->mSentFrames++;
+		RecordWriteStart(inDevice, start);
+		RecordFrameStart(frame, start);
+
+		// Short writes are continued, a write that times out without progress gives up on the frame
+		const unsigned char* data = inDevice->mTransmitData;
+		int written(0);
+		while(written < inDevice->mByteSize)
+		{
+			inDevice->mTransmitSignal.wait(lock, [inDevice, written] { return inDevice->mTransmitSize > written; });
+			int available = inDevice->mTransmitSize;
+			lock.unlock();
+			int count = WriteToDevice(inDevice, data + written, available - written);
+			lock.lock();
+			if(count == 0)
+			{
+				TimeOutTransmit(inDevice);
+				break;
+			}
+			if(count < 0)
+			{
+				FailTransmit(inDevice);
+				SetDeviceDown(inDevice);
+				break;
+			}
+			written += count;
+		}
+
+		// Slaves are primed once the frame left the serial driver, the master triggers them after that
+		if(inDevice->mSyncSlave && !inDevice->mTransmitFailed)
+		{
+			lock.unlock();
+			int drained = DrainDevice(inDevice);
+			lock.lock();
+			if(drained == 0)
+				TimeOutTransmit(inDevice);
+			if(drained < 0)
+				SetDeviceDown(inDevice);
+		}
+
+		FinishTransmit(inDevice);
+	}
+}
+
+
+
+/**
+@brief Returns if the event writer can start writing the frame handed to a device, otherwise sets when to ask again
+
+A frame starts at it's tick, the master waits for the slaves to be primed as well
+**/
+static bool IsWriteDue(NLedDevice* inDevice, chrono::steady_clock::time_point inNow, chrono::steady_clock::time_point& outRetry)
+{
+	if(inNow < inDevice->mTransmitDue)
+	{
+		outRetry = inDevice->mTransmitDue;
+		return false;
+	}
+	if(!IsOutputDrained(inDevice))
+	{
+		outRetry = inNow + sDrainPollTime;
+		return false;
+	}
+	if(inDevice != sSyncMaster)
+		return true;
+
+	// Gives up after a couple of frame times, the last slave wakes up the writer when it's primed
+	chrono::steady_clock::time_point give_up = inDevice->mTransmitDue + GetSlaveWaitTime();
+	lock_guard<mutex> lock(sOutputMutex);
+	if(inNow >= give_up || SlavesReceived(inDevice->mTransmitFrame))
+		return true;
+	outRetry = give_up;
+	return false;
+}
+
+
+
+/**
+@brief Called by the event writer when it starts writing the frame handed to a device
+**/
+static void StartWrite(NLedDevice* inDevice, chrono::steady_clock::time_point inNow)
+{
+	inDevice->mSentFrames++;
+	RecordWriteStart(inDevice, inNow);
+	RecordFrameStart(inDevice->mTransmitFrame, inNow);
+}
+
+
+
+/**
+@brief Called by the event writer when the rest of the frame handed to a device can't be written, the connection failed
+**/
+static void FailWrite(NLedDevice* inDevice, chrono::steady_clock::time_point)
+{
+	FailTransmit(inDevice);
+	SetDeviceDown(inDevice);
+}
+
+
+
+/**
+@brief Called by the event writer when the serial driver didn't take any of the frame handed to a device for the write timeout
+**/
+static void TimeOutWrite(NLedDevice* inDevice, chrono::steady_clock::time_point)
+{
+	TimeOutTransmit(inDevice);
+}
+
+
+
+/**
+@brief Called by the event writer when the frame handed to a device is written
+**/
+static void FinishWrite(NLedDevice* inDevice, chrono::steady_clock::time_point)
+{
+	FinishTransmit(inDevice);
+}
+
+
+
+/**
+@brief Starts writing the frames of a device, on it's own transmit thread or the event writer
+**/
+static void StartTransmitter(NLedDevice& inDevice)
+{
+	if(sOutputBackend == nled::OutputBackend::Events && nled::AddWriterDevice(inDevice))
+		return;
+
+	inDevice.mStopTransmit = false;
+	inDevice.mTransmitThread = thread(RunTransmitThread, &inDevice);
+	nled::ConfigureThread(inDevice.mTransmitThread, nled::ThreadRole::Output);
+}
+
+
+
+/**
+@brief Stops writing the frames of a device, waits for the current write to finish
+**/
+static void StopTransmitter(NLedDevice& inDevice)
+{
+	nled::RemoveWriterDevice(inDevice);
+	if(!inDevice.mTransmitThread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(inDevice.mTransmitMutex);
+		inDevice.mStopTransmit = true;
+	}
+	inDevice.mTransmitSignal.notify_all();
+	inDevice.mTransmitThread.join();
+}
+
+
+
+/**
+@brief Starts the long lived output thread and the transmitter of a device
+**/
+static void StartOutputThread(NLedDevice& inDevice)
+{
+	inDevice.mStopOutput = false;
+	StartTransmitter(inDevice);
+	inDevice.mOutputThread = thread(RunOutputThread, &inDevice);
+	nled::ConfigureThread(inDevice.mOutputThread, nled::ThreadRole::Output);
+}
+
+
+
+/**
+@brief Stops the output thread and the transmitter of a device, waits for the current task and write to finish
+**/
+static void StopOutputThread(NLedDevice& inDevice)
+{
+	if(!inDevice.mOutputThread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(inDevice.mOutputMutex);
+		inDevice.mStopOutput = true;
+	}
+	inDevice.mOutputSignal.notify_one();
+	inDevice.mOutputThread.join();
+	StopTransmitter(inDevice);
+}
+
+
+
+/**
+@brief Returns if a device that went down can be reopened on it's port
+
+Not when the port watcher found the port gone, UpdateDisplays removes the device and adds the one that comes back
+**/
+static bool IsPortReconnectable(const string& inPort)
+{
+	lock_guard<mutex> lock(sHotPlugMutex);
+	if(sClaimedPorts.count(inPort) == 0)
+		return false;
 
-	// Sync threads
-	for(thread& v: conversion_threads)
-		v.join();
-}
\ No newline at end of file
+	for(const NLedPortChange& change : sPortChanges)
+	{
+		if(change.mDevice == nullptr && change.mPort == inPort)
+			return false;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Reopens a device that went down, returns if it's back up. inAttempt is the amount of failed attempts before this one
+
+The device is queried again, it has to report the configuration it had. Only the first failed attempt is reported
+**/
+static bool ReconnectLedDevice(NLedDevice* ioDevice, int inAttempt)
+{
+	const PortInfo& p = ioDevice->mPortInfo;
+	if(!IsPortReconnectable(p.port))
+		return false;
+
+	ostringstream log;
+	NLedDeviceConfig config;
+	bool reconnected(false);
+	try
+	{
+		if(ioDevice->mConnection.isOpen())
+			ioDevice->mConnection.close();
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(sHandshakeTimeout);
+		reconnected = QueryLedDevice(*ioDevice, p, deadline, config, log);
+	}
+	catch(const exception& e)
+	{
+		log << "ERROR: unable to reconnect led device on port: " << p.port << ", " << e.what() << "\n";
+		if(ioDevice->mConnection.isOpen())
+			ioDevice->mConnection.close();
+	}
+
+	// Another device answered on the port, or it was flashed with a different configuration. Unsupported pin counts fall back to 8 like they did when the device was added
+	int pin_count = config.mPinCount == 16 || config.mPinCount == 32 ? config.mPinCount : 8;
+	if(reconnected && (config.mUUID != ioDevice->mUUID || config.mStripLength != ioDevice->mStripLength || config.mLedHeight != ioDevice->mLedHeight || config.mLayout != ioDevice->mLayout || pin_count != ioDevice->mPinCount))
+	{
+		log << "ERROR: led device on port: " << p.port << " changed, expected device id: " << ioDevice->mUUID << ", width: " << ioDevice->mStripLength << ", height: " << ioDevice->mLedHeight << ", pins: " << ioDevice->mPinCount <<
+			", found device id: " << config.mUUID << ", width: " << config.mStripLength << ", height: " << config.mLedHeight << ", pins: " << config.mPinCount << "\n";
+		ioDevice->mConnection.close();
+		reconnected = false;
+	}
+
+	if(!reconnected)
+	{
+		if(inAttempt == 0)
+			cout << log.str() << "WARNING: led device on port: " << p.port << " is down, retrying in the background\n";
+		return false;
+	}
+
+	// The event writer waits on the new descriptor, the next frame is written completely
+	nled::ResetWriterDevice(*ioDevice);
+	{
+		lock_guard<mutex> lock(ioDevice->mTransmitMutex);
+		ioDevice->mSentValid = false;
+		ioDevice->mReconnectCount++;
+		ioDevice->mOnline = true;
+	}
+	cout << "Reconnected led interface on port: " << p.port << ", " << p.description << ", device id: " << ioDevice->mUUID << ", handshake: " << ioDevice->mHandshakeLatency << " ms\n";
+	return true;
+}
+
+
+
+/**
+@brief Reconnect thread, reopens the devices that went down once they're due, the delay doubles with every failed attempt
+**/
+static void RunReconnectThread()
+{
+	unique_lock<mutex> lock(sReconnectMutex);
+	while(!sStopReconnect)
+	{
+		// Find the device that's due first, the transmit threads of the devices look at the device map as well
+		NLedDevice* device(nullptr);
+		chrono::steady_clock::time_point due = chrono::steady_clock::time_point::max();
+		{
+			lock_guard<mutex> output_lock(sOutputMutex);
+			for(auto& v : sLedInterfaces)
+			{
+				if(!v.second->mOnline && v.second->mReconnectDue < due)
+				{
+					device = v.second;
+					due = v.second->mReconnectDue;
+				}
+			}
+		}
+
+		if(device == nullptr)
+		{
+			sReconnectSignal.wait(lock);
+			continue;
+		}
+		if(due > chrono::steady_clock::now())
+		{
+			sReconnectSignal.wait_until(lock, due);
+			continue;
+		}
+
+		int attempt = device->mReconnectAttempts;
+		lock.unlock();
+		bool reconnected = ReconnectLedDevice(device, attempt);
+		lock.lock();
+
+		if(reconnected)
+		{
+			device->mReconnectAttempts = 0;
+			continue;
+		}
+		device->mReconnectAttempts++;
+		chrono::milliseconds delay = min(sReconnectDelay * (1 << min(device->mReconnectAttempts, 16)), sMaxReconnectDelay);
+		device->mReconnectDue = chrono::steady_clock::now() + delay;
+	}
+}
+
+
+
+/**
+@brief Starts reopening the devices that go down
+**/
+static void StartReconnectThread()
+{
+	sStopReconnect = false;
+	sReconnectThread = thread(RunReconnectThread);
+}
+
+
+
+/**
+@brief Stops reopening devices, waits for the current attempt to finish. Devices that are down stay down until it's started again
+**/
+static void StopReconnectThread()
+{
+	if(!sReconnectThread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(sReconnectMutex);
+		sStopReconnect = true;
+	}
+	sReconnectSignal.notify_all();
+	sReconnectThread.join();
+}
+
+
+
+/**
+@brief Hands the given task to the output thread of every device and waits for all of them to finish
+
+Nothing is allocated and no threads are created, the output threads are started when the devices are found
+**/
+static void RunOnDevices(NLedOutputTask inTask)
+{
+	{
+		lock_guard<mutex> lock(sOutputMutex);
+		sPendingOutputs = (int)sLedInterfaces.size();
+	}
+
+	// Wake up the output threads
+	for(auto& v : sLedInterfaces)
+	{
+		{
+			lock_guard<mutex> lock(v.second->mOutputMutex);
+			v.second->mOutputTask = inTask;
+		}
+		v.second->mOutputSignal.notify_one();
+	}
+
+	// Wait for all of them to finish
+	unique_lock<mutex> lock(sOutputMutex);
+	sOutputDone.wait(lock, [] { return sPendingOutputs == 0; });
+}
+
+
+
+/**
+@brief Returns if every device finished the submitted frame, call with sOutputMutex locked
+**/
+static bool FramePresented(unsigned long long inFrame)
+{
+	for(auto& v : sLedInterfaces)
+	{
+		if(v.second->mPresentedFrame < inFrame)
+			return false;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Waits until every device wrote all frames, after that the output and transmit threads are idle
+**/
+static void WaitForSubmittedFrames()
+{
+	unique_lock<mutex> lock(sOutputMutex);
+	sOutputDone.wait(lock, [] { return FramePresented(sSubmittedFrames); });
+}
+
+
+
+/**
+@brief Waits until every device converted all submitted frames, after that the output threads are idle
+
+The last frames can still be written, the transmit threads keep going while the next frame is converted
+**/
+static void WaitForQueuedFrames()
+{
+	unique_lock<mutex> lock(sOutputMutex);
+	sOutputDone.wait(lock, []
+	{
+		for(auto& v : sLedInterfaces)
+		{
+			if(v.second->mQueuedFrames > 0)
+				return false;
+		}
+		return true;
+	});
+}
+
+
+
+/**
+@brief Finds the led device for the given display number
+**/
+static NLedDevice* FindLedDevice(int inDisplayNumber)
+{
+	// Find in map
+	NLedDeviceMap::iterator it = sDisplayToInterfaceMap.find(inDisplayNumber);
+	
+	// Return pointer or null
+	return it == sDisplayToInterfaceMap.end() ? nullptr : it->second;
+}
+
+
+
+/**
+@brief Drops the flat array of display numbers, GetAvailableDisplayNumbers builds it again
+**/
+static void ResetDisplayNumbers()
+{
+	delete[] sLedDisplayNumbers;
+	sLedDisplayNumbers = nullptr;
+}
+
+
+
+/**
+@brief Starts using a probed device, returns false when it's id is in use, the device is deleted then
+
+The other devices keep running, the configuration of usb devices is stored in ioCache
+**/
+static bool AddLedDevice(NLedDevice* ioDevice, bool inCached, NLedDeviceCache& ioCache)
+{
+	const PortInfo& p = ioDevice->mPortInfo;
+
+	// Make sure the id is unique for the device and displays attached to device, a stale cache entry can collide
+	if(sLedInterfaces.find(ioDevice->mUUID) != sLedInterfaces.end() ||
+		sDisplayToInterfaceMap.find(ioDevice->mPanelUUIDOne) != sDisplayToInterfaceMap.end() ||
+		sDisplayToInterfaceMap.find(ioDevice->mPanelUUIDTwo) != sDisplayToInterfaceMap.end())
+	{
+		cout << "ERROR: device id: " << ioDevice->mUUID << " already in use, skipping device on port: " << p.port << ", " << p.description << "\n";
+		ioCache.erase(p.serial_number);
+		DeleteLedDevice(ioDevice);
+		return false;
+	}
+
+	// Frames submitted before don't apply to it, it's a slave when there's a frame sync master
+	ioDevice->mPresentedFrame = sSubmittedFrames;
+	ioDevice->mSyncSlave = sSyncMaster != nullptr;
+
+	// Store results local to module (for fast access later on), the transmit threads of the other devices look at them
+	{
+		lock_guard<mutex> lock(sOutputMutex);
+		sLedInterfaces[ioDevice->mUUID] = ioDevice;
+		sDisplayToInterfaceMap[ioDevice->mPanelUUIDOne] = ioDevice;
+		sDisplayToInterfaceMap[ioDevice->mPanelUUIDTwo] = ioDevice;
+	}
+	ResetDisplayNumbers();
+
+	// Start the thread that converts and sends frames
+	StartOutputThread(*ioDevice);
+
+	cout << "Added led interface on port: " << p.port << ", " << p.description << ", device id: "<< ioDevice->mUUID <<", width: " << ioDevice->mStripLength << ", height: " << ioDevice->mLedHeight << ", pins: " << ioDevice->mPinCount;
+	if(inCached)
+		cout << ", cached\n";
+	else
+		cout << ", handshake: " << ioDevice->mHandshakeLatency << " ms\n";
+
+	// Remember the configuration of usb devices for the next start
+	if(!p.serial_number.empty())
+	{
+		NLedDeviceConfig& config = ioCache[p.serial_number];
+		config.mUUID = ioDevice->mUUID;
+		config.mStripLength = ioDevice->mStripLength;
+		config.mLedHeight = ioDevice->mLedHeight;
+		config.mLayout = ioDevice->mLayout;
+		config.mPinCount = ioDevice->mPinCount;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Stops using a device and deletes it, waits for it's current write. The other devices keep running
+**/
+static void RemoveLedDevice(NLedDevice* ioDevice)
+{
+	// The device could be reopened meanwhile
+	StopReconnectThread();
+	StopOutputThread(*ioDevice);
+	{
+		lock_guard<mutex> lock(sOutputMutex);
+		sLedInterfaces.erase(ioDevice->mUUID);
+		sDisplayToInterfaceMap.erase(ioDevice->mPanelUUIDOne);
+		sDisplayToInterfaceMap.erase(ioDevice->mPanelUUIDTwo);
+	}
+	sOutputDone.notify_all();
+	ResetDisplayNumbers();
+
+	// Without the master the slaves can't be triggered, the role is part of the frame header
+	if(ioDevice == sSyncMaster)
+	{
+		WaitForSubmittedFrames();
+		sSyncMaster = nullptr;
+		for(auto& v : sLedInterfaces)
+		{
+			v.second->mSyncSlave = false;
+			v.second->mSentValid = false;
+		}
+	}
+
+	DeleteLedDevice(ioDevice);
+	StartReconnectThread();
+}
+
+
+
+/**
+@brief Finds the led device that uses the given port
+**/
+static NLedDevice* FindPortDevice(const string& inPort)
+{
+	for(auto& v : sLedInterfaces)
+	{
+		if(v.second->mPortInfo.port == inPort)
+			return v.second;
+	}
+	return nullptr;
+}
+
+
+
+/**
+@brief Drops the changes found by the port watcher, only the ports of the devices in use stay claimed. Call with the watcher stopped
+**/
+static void ResetPortChanges()
+{
+	lock_guard<mutex> lock(sHotPlugMutex);
+	for(NLedPortChange& change : sPortChanges)
+	{
+		if(change.mDevice != nullptr)
+			DeleteLedDevice(change.mDevice);
+	}
+	sPortChanges.clear();
+
+	sClaimedPorts.clear();
+	for(auto& v : sLedInterfaces)
+		sClaimedPorts.insert(v.second->mPortInfo.port);
+}
+
+
+
+/**
+@brief Called on the watcher thread, probes the new ports and hands the changes to UpdateDisplays
+
+Ports in use are never probed. A port that disappeared is released right away, the device can come back on it
+**/
+static void OnPortsChanged(const vector<string>& inAdded, const vector<string>& inRemoved)
+{
+	vector<PortInfo> new_ports;
+	{
+		lock_guard<mutex> lock(sHotPlugMutex);
+		for(const string& port : inRemoved)
+		{
+			if(sClaimedPorts.erase(port) > 0)
+				sPortChanges.push_back(NLedPortChange{ port, nullptr, false });
+		}
+
+		// Claim the new ports that pass the filters while they're probed
+		for(const PortInfo& p : serial::list_ports())
+		{
+			if(find(inAdded.begin(), inAdded.end(), p.port) == inAdded.end() || sClaimedPorts.count(p.port) > 0 || !MatchesPortFilters(p))
+				continue;
+			sClaimedPorts.insert(p.port);
+			new_ports.push_back(p);
+		}
+	}
+	if(new_ports.empty())
+		return;
+
+	NLedDeviceCache device_cache = LoadDeviceCache();
+	vector<NLedDevice*> new_devices;
+	vector<bool> cached_devices;
+	vector<ostringstream> probe_logs;
+	ProbePorts(new_ports, device_cache, new_devices, cached_devices, probe_logs);
+
+	lock_guard<mutex> lock(sHotPlugMutex);
+	for(size_t i=0; i < new_ports.size(); i++)
+	{
+		cout << probe_logs[i].str();
+		if(new_devices[i]->mValid)
+		{
+			sPortChanges.push_back(NLedPortChange{ new_ports[i].port, new_devices[i], cached_devices[i] });
+			continue;
+		}
+
+		// Probed again on it's next event
+		sClaimedPorts.erase(new_ports[i].port);
+		DeleteLedDevice(new_devices[i]);
+	}
+}
+
+
+
+/**
+@brief Initialize all the available displays
+**/
+void nled::InitDisplays(float inGammaValue)
+{
+	// Clear all existing led devices, the port watcher waits for the new ones
+	nled::StopPortWatcher();
+	StopReconnectThread();
+	WaitForSubmittedFrames();
+	sSyncMaster = nullptr;
+	for(auto& v : sLedInterfaces)
+		StopOutputThread(*v.second);
+	sLedInterfaces.clear();
+	sDisplayToInterfaceMap.clear();
+
+	// Only ports that pass the filters are probed
+	vector<PortInfo> found_devices;
+	for(const PortInfo& p : serial::list_ports())
+	{
+		if(MatchesPortFilters(p))
+			found_devices.push_back(p);
+	}
+
+	// Query all ports at once
+	NLedDeviceCache device_cache = LoadDeviceCache();
+	vector<NLedDevice*> new_devices;
+	vector<bool> cached_devices;
+	vector<ostringstream> probe_logs;
+	ProbePorts(found_devices, device_cache, new_devices, cached_devices, probe_logs);
+
+	// Add valid interfaces in port order
+	for(size_t i=0; i < found_devices.size(); i++)
+	{
+		cout << probe_logs[i].str();
+
+		// Make sure the device is valid (initialized and open)
+		if(!new_devices[i]->mValid)
+		{
+			DeleteLedDevice(new_devices[i]);
+			continue;
+		}
+		AddLedDevice(new_devices[i], cached_devices[i], device_cache);
+	}
+
+	// Store the configurations of all usb devices seen so far
+	if(!sDeviceCachePath.empty())
+		SaveDeviceCache(device_cache);
+
+	// Signal success
+	sDisplayGeneration++;
+	std::cout << "Found: " << sLedInterfaces.size() << " valid LED interfaces\n";
+
+	// Create gamma and conversion tables
+	nled::InitConversion(inGammaValue);
+	std::cout << "Using " << nled::GetConversionEngineName(nled::GetConversionEngine()) << " led conversion, " << nled::GetTransposeKernelName(nled::GetBestTransposeKernel()) << " transpose kernel\n";
+
+	// Watch for devices that connect or disconnect and reopen the ones that go down from now on
+	sDisplaysInitialized = true;
+	ResetPortChanges();
+	if(sHotPlug)
+		nled::StartPortWatcher(OnPortsChanged);
+	StartReconnectThread();
+}
+
+
+
+/**
+@brief Closes all serial connections and clears display buffers
+**/
+void nled::ClearDisplays()
+{
+	nled::StopPortWatcher();
+	StopReconnectThread();
+	WaitForSubmittedFrames();
+	sSyncMaster = nullptr;
+	for(auto& v : sLedInterfaces)
+	{
+		// Stop sending frames
+		StopOutputThread(*v.second);
+
+		// Close serial connection
+		v.second->mConnection.close();
+		
+		// Delete data buffers
+		nled::DeleteConversionBuffers(*v.second);
+	}
+
+	// Clear interfaces
+	sLedInterfaces.clear();
+	sDisplayToInterfaceMap.clear();
+	sDisplaysInitialized = false;
+	ResetPortChanges();
+	sDisplayGeneration++;
+
+	// Clear sampled display numbers
+	ResetDisplayNumbers();
+
+	// Delete gamma and conversion tables
+	nled::ClearConversion();
+}
+
+
+
+/**
+@brief Enables or disables watching for led devices that connect or disconnect
+**/
+bool nled::SetHotPlug(bool inEnabled)
+{
+	nled::StopPortWatcher();
+	ResetPortChanges();
+
+	sHotPlug = inEnabled && nled::IsPortWatcherSupported();
+	if(sHotPlug && sDisplaysInitialized)
+		sHotPlug = nled::StartPortWatcher(OnPortsChanged);
+	return sHotPlug == inEnabled;
+}
+
+
+
+/**
+@brief Returns if led devices that connect or disconnect are picked up
+**/
+bool nled::GetHotPlug()
+{
+	return sHotPlug;
+}
+
+
+
+/**
+@brief Adds the devices found and removes the ones that disconnected since the last call
+**/
+bool nled::UpdateDisplays()
+{
+	vector<NLedPortChange> changes;
+	{
+		lock_guard<mutex> lock(sHotPlugMutex);
+		changes.swap(sPortChanges);
+	}
+	if(changes.empty())
+		return false;
+
+	NLedDeviceCache device_cache = LoadDeviceCache();
+	for(const NLedPortChange& change : changes)
+	{
+		// The port disappeared, stop using the device on it
+		if(change.mDevice == nullptr)
+		{
+			NLedDevice* device = FindPortDevice(change.mPort);
+			if(device == nullptr)
+				continue;
+
+			int panel_one = device->mPanelUUIDOne;
+			int panel_two = device->mPanelUUIDTwo;
+			cout << "Removed led interface on port: " << change.mPort << ", device id: " << device->mUUID << "\n";
+			RemoveLedDevice(device);
+
+			if(sDisplayCallback != nullptr)
+			{
+				sDisplayCallback(panel_one, false);
+				sDisplayCallback(panel_two, false);
+			}
+			continue;
+		}
+
+		// A device on a new port, the port is released when it can't be used
+		int panel_one = change.mDevice->mPanelUUIDOne;
+		int panel_two = change.mDevice->mPanelUUIDTwo;
+		if(!AddLedDevice(change.mDevice, change.mCached, device_cache))
+		{
+			lock_guard<mutex> lock(sHotPlugMutex);
+			sClaimedPorts.erase(change.mPort);
+			continue;
+		}
+
+		if(sDisplayCallback != nullptr)
+		{
+			sDisplayCallback(panel_one, true);
+			sDisplayCallback(panel_two, true);
+		}
+	}
+
+	if(!sDeviceCachePath.empty())
+		SaveDeviceCache(device_cache);
+
+	sDisplayGeneration++;
+	return true;
+}
+
+
+
+/**
+@brief Sets the function called by UpdateDisplays for every display that connected or disconnected
+**/
+void nled::SetDisplayCallback(DisplayCallback inCallback)
+{
+	sDisplayCallback = inCallback;
+}
+
+
+
+/**
+@brief Returns a number that changes every time displays are added or removed
+**/
+unsigned int nled::GetDisplayGeneration()
+{
+	return sDisplayGeneration;
+}
+
+
+
+/**
+@brief Sets how long InitDisplays waits for the devices to answer the interface query
+**/
+void nled::SetHandshakeTimeout(int inMilliseconds)
+{
+	sHandshakeTimeout = inMilliseconds > 0 ? inMilliseconds : 1;
+}
+
+
+
+/**
+@brief Returns how long InitDisplays waits for the devices to answer the interface query
+**/
+int nled::GetHandshakeTimeout()
+{
+	return sHandshakeTimeout;
+}
+
+
+
+/**
+@brief Only probes usb devices with the given vendor and product id
+**/
+void nled::AddPortFilter(int inVendorId, int inProductId, const char* inSerialNumber)
+{
+	NLedPortFilter filter;
+	filter.mVendorId = inVendorId;
+	filter.mProductId = inProductId;
+	filter.mSerialNumber = inSerialNumber != nullptr ? inSerialNumber : "";
+	sPortFilters.push_back(filter);
+}
+
+
+
+/**
+@brief Removes all port filters
+**/
+void nled::ClearPortFilters()
+{
+	sPortFilters.clear();
+}
+
+
+
+/**
+@brief Sets the file the configuration of usb devices is cached in
+**/
+void nled::SetDeviceCache(const char* inPath)
+{
+	sDeviceCachePath = inPath != nullptr ? inPath : "";
+}
+
+
+
+/**
+@brief Returns the handshake latency of the device the display belongs to
+**/
+float nled::GetHandshakeLatency(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	return found_device == nullptr ? -1.0f : found_device->mHandshakeLatency;
+}
+
+
+
+/**
+@brief Returns if a display exists or not
+**/
+bool nled::DisplayExists(int inDisplayNumber)
+{
+	int* displays = GetAvailableDisplayNumbers();
+	for(int i=0; i < GetDisplayCount(); i++)
+	{
+		if(displays[i] == inDisplayNumber)
+			return true;
+	}
+	return false;
+}
+
+
+
+/**
+@brief Returns all the available led displays
+**/
+int nled::GetDisplayCount()
+{
+	return sLedInterfaces.size() * 2;
+}
+
+
+/**
+@brief Returns all the available unique display numbers
+**/
+int* nled::GetAvailableDisplayNumbers()
+{
+	if(sLedDisplayNumbers == nullptr)
+	{
+		sLedDisplayNumbers = GetDisplayCount() > 0 ? new int[GetDisplayCount()] : nullptr;
+		
+		int count(0);
+		for(auto v : sLedInterfaces)
+		{
+			NLedDevice* current_dev = v.second;
+			sLedDisplayNumbers[(count * 2) + 0] = v.second->mPanelUUIDOne;
+			sLedDisplayNumbers[(count * 2) + 1] = v.second->mPanelUUIDTwo;
+			count++;
+		}
+	}
+
+	return sLedDisplayNumbers;
+}
+
+
+
+/**
+@brief Returns the display size for the given display number
+**/
+int nled::GetDisplaySize(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	// Return the info
+	return found_device == nullptr ? -1 : (found_device->mLedHeight / 2) * found_device->mStripLength;
+}
+
+
+/**
+@brief Returns the total amount of bytes for a display
+**/
+int nled::GetDisplayByteSize(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	// Return info
+	return found_device == nullptr ? -1 : (found_device->mLedHeight / 2) * found_device->mStripLength * found_device->mDisplayBytesPerLed;
+}
+
+
+
+/**
+@brief Returns the max number of bytes relative to the biggest available display
+**/
+int nled::GetMaxDisplayByteSize()
+{
+	int max_size(-1);
+	for(int i=0; i< GetDisplayCount(); i++)
+	{
+		int s = GetDisplayByteSize(GetAvailableDisplayNumbers()[i]);
+		max_size = s > max_size ? s : max_size;
+	}
+	return max_size;
+}
+
+
+
+/**
+@brief Returns amount of bytes per led of the default pixel format (3 -> RGB)
+**/
+int nled::GetBytesPerLed()
+{
+	return sBytesPerLed;
+}
+
+
+
+/**
+@brief Returns amount of bytes per led in the display data of a display
+**/
+int nled::GetBytesPerLed(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	return found_device == nullptr ? -1 : found_device->mDisplayBytesPerLed;
+}
+
+
+
+
+/**
+@brief Returns if the display data of the device is transposed relative to the strips
+**/
+static bool IsTransposed(const NLedDevice& inDevice)
+{
+	return inDevice.mTopology.mRotation == nled::Rotation::CW90 || inDevice.mTopology.mRotation == nled::Rotation::CW270;
+}
+
+
+
+/**
+@brief Returns the stride (amount of leds on a single connected strip, or strips when the display is rotated by 90 degrees)
+**/
+int nled::GetDisplayStride(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	if(found_device == nullptr)
+		return -1;
+	return IsTransposed(*found_device) ? found_device->mLedHeight / 2 : found_device->mStripLength;
+}
+
+
+
+/**
+@brief Returns the height of the display
+**/
+int nled::GetDisplayHeight(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	if(found_device == nullptr)
+		return -1;
+	return IsTransposed(*found_device) ? found_device->mStripLength : found_device->mLedHeight / 2;
+}
+
+
+
+/**
+@brief Sets the wiring of the device the display belongs to
+**/
+bool nled::SetDisplayTopology(int inDisplayNumber, const Topology& inTopology)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return false;
+
+	WaitForSubmittedFrames();
+	found_device->mTopology = inTopology;
+	nled::BuildGatherIndex(*found_device);
+	return true;
+}
+
+
+
+/**
+@brief Returns the wiring of the device the display belongs to
+**/
+nled::Topology nled::GetDisplayTopology(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	return found_device == nullptr ? Topology() : found_device->mTopology;
+}
+
+
+
+/**
+@brief Sets the color layout of the device the display belongs to
+**/
+bool nled::SetDisplayPixelFormat(int inDisplayNumber, PixelFormat inFormat, bool inExtractWhite)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return false;
+
+	WaitForSubmittedFrames();
+	nled::SetPixelFormat(*found_device, inFormat, inExtractWhite);
+	return true;
+}
+
+
+
+/**
+@brief Returns the color layout of the device the display belongs to
+**/
+nled::PixelFormat nled::GetDisplayPixelFormat(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	return found_device == nullptr ? PixelFormat::RGB : found_device->mPixelFormat;
+}
+
+
+
+/**
+@brief Returns the total amount of pixels of all displays combined
+**/
+int nled::GetTotalDisplaySize()
+{
+	int total_count(0);
+	for(auto v : sLedInterfaces)
+		total_count += (v.second->mLedHeight * v.second->mStripLength);
+	return total_count;
+}
+
+
+
+/**
+@brief Returns the total byte size for all displays
+**/
+int nled::GetTotalDisplayByteSize()
+{
+	int total_size(0);
+	for(auto v : sLedInterfaces)
+		total_size += (v.second->mLedHeight * v.second->mStripLength * v.second->mDisplayBytesPerLed);
+	return total_size;
+}
+
+
+
+/**
+@brief Sets the data for an individual led panel
+**/
+void nled::SetData(int inDisplayIndex, unsigned char* inData)
+{
+	// Find the right device to set the data for
+	NLedDevice* found_device = FindLedDevice(inDisplayIndex);
+	
+	// Make sure it's valid
+	assert(found_device != nullptr);
+	if(found_device == nullptr)
+		return;
+
+	// Point panel to right data, new data invalidates the converted rows of the panel
+	int panel = found_device->mPanelUUIDOne == inDisplayIndex ? 0 : 1;
+	unsigned char*& panel_data = panel == 0 ? found_device->mUserDataPanelOne : found_device->mUserDataPanelTwo;
+	if(panel_data != inData)
+		nled::FlagRows(*found_device, found_device->mMarkedRows, panel, 0, -1);
+	panel_data = inData;
+}
+
+
+
+/**
+@brief Returns the data pointer for the individual led display
+**/
+unsigned char* nled::GetData(int inDisplayIndex)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayIndex);
+	assert(found_device != nullptr);
+	
+	return found_device->mPanelUUIDOne == inDisplayIndex ? found_device->mUserDataPanelOne : found_device->mUserDataPanelTwo;
+}
+
+
+
+/**
+@brief Flags rows of a display as changed since the previous frame, they are handed to the conversion with the next frame
+**/
+void nled::MarkDirty(int inDisplayNumber, int inFirstRow, int inRowCount)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return;
+
+	nled::FlagRows(*found_device, found_device->mMarkedRows, found_device->mPanelUUIDOne == inDisplayNumber ? 0 : 1, inFirstRow, inRowCount);
+}
+
+
+
+/**
+@brief Converts and sends the data in the display buffers to the various devices
+
+Note that this method rund parallel for every device and syncs up before returning.
+It returns once every device converted the frame, the frame is written while the next one is converted
+**/
+nled::FrameHandle nled::EndDisplay()
+{
+	// Submitted frames go first, after that the output threads are idle
+	WaitForQueuedFrames();
+
+	// Convert straight from the user data, the frame slots no longer hold the last frame converted
+	for(auto& v : sLedInterfaces)
+	{
+		NLedDevice* device = v.second;
+		device->mRGBDataPanelOne = device->mUserDataPanelOne;
+		device->mRGBDataPanelTwo = device->mUserDataPanelTwo;
+		nled::ApplyRowFlags(*device, device->mMarkedRows);
+		device->mFrameValid = false;
+	}
+
+	// Start threaded conversion and uploading
+	sSubmittedFrames++;
+	sEndDisplayDue = ScheduleFrame();
+	RunOnDevices(FlushUserDataToDevice);
+	return sSubmittedFrames;
+}
+
+
+
+/**
+@brief Copies the display data in to library owned frame slots and hands the frame to the output threads without waiting
+
+Every device buffers two frames, when both are in use this waits for the oldest one to be converted
+**/
+nled::FrameHandle nled::SubmitFrame()
+{
+	// Wait for a free slot on every device
+	{
+		unique_lock<mutex> lock(sOutputMutex);
+		sOutputDone.wait(lock, []
+		{
+			for(auto& v : sLedInterfaces)
+			{
+				if(v.second->mQueuedFrames >= sFrameSlotCount)
+					return false;
+			}
+			return true;
+		});
+	}
+
+	FrameHandle frame = sSubmittedFrames + 1;
+	chrono::steady_clock::time_point due = ScheduleFrame();
+	for(auto& v : sLedInterfaces)
+	{
+		NLedDevice* device = v.second;
+		int slot = device->mSubmitSlot;
+		nled::SnapshotFrame(*device, slot);
+		device->mFrameNumbers[slot] = frame;
+		device->mFrameDue[slot] = due;
+		device->mSubmitSlot = (slot + 1) % sFrameSlotCount;
+
+		// Hand it to the output thread
+		{
+			lock_guard<mutex> lock(device->mOutputMutex);
+			device->mQueuedFrames++;
+		}
+		device->mOutputSignal.notify_one();
+	}
+
+	sSubmittedFrames = frame;
+	return frame;
+}
+
+
+
+/**
+@brief Returns if every device finished sending the submitted frame
+**/
+bool nled::IsFramePresented(FrameHandle inFrame)
+{
+	lock_guard<mutex> lock(sOutputMutex);
+	return FramePresented(inFrame);
+}
+
+
+
+/**
+@brief Waits until every device finished sending the submitted frame
+**/
+void nled::WaitForFrame(FrameHandle inFrame)
+{
+	unique_lock<mutex> lock(sOutputMutex);
+	sOutputDone.wait(lock, [inFrame] { return FramePresented(inFrame); });
+}
+
+
+
+/**
+@brief Returns the last submitted frame every device finished sending
+**/
+nled::FrameHandle nled::GetPresentedFrame()
+{
+	FrameHandle presented = sSubmittedFrames;
+	for(auto& v : sLedInterfaces)
+	{
+		FrameHandle device_frame = v.second->mPresentedFrame;
+		presented = device_frame < presented ? device_frame : presented;
+	}
+	return presented;
+}
+
+
+
+/**
+@brief Sends the precomputed all black frame to every device, no conversion is involved
+**/
+void nled::Blackout()
+{
+	WaitForQueuedFrames();
+	sSubmittedFrames++;
+	RunOnDevices(BlackoutDevice);
+}
+
+
+
+/**
+@brief Enables or disables skipping frames that are identical to the last frame send to a device
+**/
+void nled::SetSkipUnchangedFrames(bool inSkip)
+{
+	sSkipUnchangedFrames = inSkip;
+}
+
+
+
+/**
+@brief Enables or disables dropping frames that wait for the previous frame to drain
+**/
+void nled::SetDropStaleFrames(bool inDrop)
+{
+	WaitForSubmittedFrames();
+	sDropStaleFrames = inDrop;
+}
+
+
+
+/**
+@brief Returns if frames that wait for the previous frame to drain are dropped
+**/
+bool nled::GetDropStaleFrames()
+{
+	return sDropStaleFrames;
+}
+
+
+
+/**
+@brief Sets the size of the chunks frames are streamed to the devices in, 0 writes frames once they're completely converted
+**/
+void nled::SetStreamChunkSize(int inByteCount)
+{
+	sStreamChunkSize = inByteCount < 0 ? 0 : inByteCount;
+}
+
+
+
+/**
+@brief Returns the size of the chunks frames are streamed to the devices in, 0 when frames aren't streamed
+**/
+int nled::GetStreamChunkSize()
+{
+	return sStreamChunkSize;
+}
+
+
+
+/**
+@brief Returns if frames identical to the last frame send to a device are skipped
+**/
+bool nled::GetSkipUnchangedFrames()
+{
+	return sSkipUnchangedFrames;
+}
+
+
+
+/**
+@brief Returns the amount of frames written to the device the display belongs to, -1 if display isn't valid
+**/
+int nled::GetSentFrameCount(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	if(found_device == nullptr)
+		return -1;
+
+	lock_guard<mutex> lock(found_device->mTransmitMutex);
+	return found_device->mSentFrames;
+}
+
+
+
+/**
+@brief Returns the amount of frames skipped by the device the display belongs to, -1 if display isn't valid
+**/
+int nled::GetSkippedFrameCount(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+
+	if(found_device == nullptr)
+		return -1;
+
+	lock_guard<mutex> lock(found_device->mTransmitMutex);
+	return found_device->mSkippedFrames;
+}
+
+
+
+/**
+@brief Returns the amount of frames the device the display belongs to dropped for a newer frame, -1 if display isn't valid
+**/
+int nled::GetDroppedFrameCount(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return -1;
+
+	lock_guard<mutex> lock(found_device->mTransmitMutex);
+	return found_device->mDroppedFrames;
+}
+
+
+
+/**
+@brief Returns the amount of frames the device the display belongs to couldn't write completely, -1 if display isn't valid
+**/
+int nled::GetPartialFrameCount(int inDisplayNumber)
+{
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return -1;
+
+	lock_guard<mutex> lock(found_device->mTransmitMutex);
+	return found_device->mPartialFrames;
+}
+
+
+
+/**
+@brief Returns the connection state and error counters of the device the display belongs to
+**/
+nled::DeviceStatus nled::GetDeviceStatus(int inDisplayNumber)
+{
+	DeviceStatus status;
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return status;
+
+	{
+		lock_guard<mutex> lock(found_device->mTransmitMutex);
+		status.mOnline = found_device->mOnline;
+		status.mErrorCount = found_device->mErrorCount;
+		status.mLostFrames = found_device->mLostFrames;
+		status.mReconnectCount = found_device->mReconnectCount;
+	}
+	lock_guard<mutex> lock(sReconnectMutex);
+	status.mReconnectAttempts = found_device->mReconnectAttempts;
+	return status;
+}
+
+
+
+/**
+@brief Selects how the converted frames are written to the devices
+**/
+bool nled::SetOutputBackend(OutputBackend inBackend, int inThreadCount)
+{
+	if(inBackend == OutputBackend::Events && !nled::IsWriterSupported())
+	{
+		cout << "WARNING: event driven output isn't supported on this platform, using a transmit thread per device\n";
+		return false;
+	}
+
+	// Move every idle device to the new backend, devices that can't be driven by the writer keep a transmit thread
+	// Devices that are down aren't reopened meanwhile
+	StopReconnectThread();
+	WaitForSubmittedFrames();
+	for(auto& v : sLedInterfaces)
+		StopTransmitter(*v.second);
+	nled::StopWriters();
+
+	sOutputBackend = OutputBackend::Threads;
+	if(inBackend == OutputBackend::Events && nled::StartWriters(inThreadCount, chrono::milliseconds(sSerialTimeout), IsWriteDue, StartWrite, FinishWrite, FailWrite, TimeOutWrite))
+		sOutputBackend = OutputBackend::Events;
+
+	for(auto& v : sLedInterfaces)
+		StartTransmitter(*v.second);
+	if(sDisplaysInitialized)
+		StartReconnectThread();
+	return sOutputBackend == inBackend;
+}
+
+
+
+/**
+@brief Returns how the converted frames are written to the devices
+**/
+nled::OutputBackend nled::GetOutputBackend()
+{
+	return sOutputBackend;
+}
+
+
+/**
+@brief Sets the frame rate the sync pulse and the frame pacing are based on
+**/
+void nled::SetTargetFrameRate(float inFramesPerSecond)
+{
+	assert(inFramesPerSecond > 0.0f);
+	sTargetFrameRate = inFramesPerSecond > 0.0f ? inFramesPerSecond : 30.0f;
+}
+
+
+
+/**
+@brief Returns the frame rate the sync pulse and the frame pacing are based on
+**/
+float nled::GetTargetFrameRate()
+{
+	return sTargetFrameRate;
+}
+
+
+
+/**
+@brief Enables or disables spacing out frame writes at the target frame rate, restarts the pacing clock
+**/
+void nled::SetFramePacing(bool inEnabled)
+{
+	sFramePacing = inEnabled;
+	sLastFrameDue = chrono::steady_clock::time_point();
+}
+
+
+
+/**
+@brief Returns if frame writes are spaced out at the target frame rate
+**/
+bool nled::GetFramePacing()
+{
+	return sFramePacing;
+}
+
+
+
+/**
+@brief Selects what happens to frames that are handed over after their tick
+**/
+void nled::SetLateFramePolicy(LateFramePolicy inPolicy)
+{
+	sLateFramePolicy = inPolicy;
+}
+
+
+
+/**
+@brief Returns what happens to frames that are handed over after their tick
+**/
+nled::LateFramePolicy nled::GetLateFramePolicy()
+{
+	return sLateFramePolicy;
+}
+
+
+
+/**
+@brief Returns the measured frame rate and jitter of the device the display belongs to, together with the pacing counters
+**/
+nled::FrameTiming nled::GetFrameTiming(int inDisplayNumber)
+{
+	FrameTiming timing;
+	timing.mLateFrames = sLateFrames;
+	timing.mDroppedTicks = sDroppedTicks;
+
+	// Skew of the newest frame written by multiple devices, the totals include the frames still measured
+	{
+		lock_guard<mutex> lock(sTimingMutex);
+		unsigned long long newest_frame(0);
+		double skew_sum(sSkewSum), max_skew(sMaxSkew);
+		int measurements(sSkewMeasurements);
+		for(int i=0; i < sSkewFrameCount; i++)
+		{
+			if(sSkewWrites[i] < 2)
+				continue;
+
+			double skew = chrono::duration<double>(sSkewLastStart[i] - sSkewFirstStart[i]).count();
+			skew_sum += skew;
+			max_skew = skew > max_skew ? skew : max_skew;
+			measurements++;
+			if(sSkewFrames[i] > newest_frame)
+			{
+				newest_frame = sSkewFrames[i];
+				timing.mWriteSkew = (float)(skew * 1000.0);
+			}
+		}
+		timing.mMeanWriteSkew = measurements > 0 ? (float)((skew_sum / measurements) * 1000.0) : 0.0f;
+		timing.mMaxWriteSkew = (float)(max_skew * 1000.0);
+	}
+
+	NLedDevice* found_device = FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(found_device);
+	if(found_device == nullptr)
+		return timing;
+
+	lock_guard<mutex> lock(found_device->mTransmitMutex);
+	timing.mFrameCount = found_device->mTimedFrames;
+	if(found_device->mTimedFrames == 0)
+		return timing;
+
+	// Rate from the mean interval, jitter is the standard deviation of the intervals
+	double mean = found_device->mIntervalSum / found_device->mTimedFrames;
+	double variance = (found_device->mIntervalSquareSum / found_device->mTimedFrames) - (mean * mean);
+	timing.mFrameRate = mean > 0.0 ? (float)(1.0 / mean) : 0.0f;
+	timing.mJitter = variance > 0.0 ? (float)(sqrt(variance) * 1000.0) : 0.0f;
+	return timing;
+}
+
+
+
+/**
+@brief Clears the measured frame timing of every device and the pacing counters
+**/
+void nled::ResetFrameTiming()
+{
+	sLateFrames = 0;
+	sDroppedTicks = 0;
+	{
+		lock_guard<mutex> lock(sTimingMutex);
+		for(int i=0; i < sSkewFrameCount; i++)
+		{
+			sSkewFrames[i] = 0;
+			sSkewWrites[i] = 0;
+		}
+		sSkewSum = 0.0;
+		sMaxSkew = 0.0;
+		sSkewMeasurements = 0;
+	}
+	for(auto& v : sLedInterfaces)
+	{
+		lock_guard<mutex> lock(v.second->mTransmitMutex);
+		v.second->mLastWriteStart = chrono::steady_clock::time_point();
+		v.second->mTimedFrames = 0;
+		v.second->mIntervalSum = 0.0;
+		v.second->mIntervalSquareSum = 0.0;
+	}
+}
+
+
+
+/**
+@brief Selects the device that sends the frame sync pulse, the other devices are send their frames in slave mode
+**/
+bool nled::SetFrameSyncMaster(int inDisplayNumber)
+{
+	NLedDevice* found_device = inDisplayNumber < 0 ? nullptr : FindLedDevice(inDisplayNumber);
+
+	// Make sure the device was found
+	assert(inDisplayNumber < 0 || found_device != nullptr);
+	if(inDisplayNumber >= 0 && found_device == nullptr)
+		return false;
+
+	// The role is part of the frame header, make sure the next frame is written to every device
+	WaitForSubmittedFrames();
+	sSyncMaster = found_device;
+	for(auto& v : sLedInterfaces)
+	{
+		v.second->mSyncSlave = found_device != nullptr && v.second != found_device;
+		v.second->mSentValid = false;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Returns the first display of the frame sync master, -1 when every device syncs on it's own
+**/
+int nled::GetFrameSyncMaster()
+{
+	return sSyncMaster == nullptr ? -1 : sSyncMaster->mPanelUUIDOne;
+}
+
+
+
+/**
+@brief Restarts every library thread with the new real time settings and prefaults the frame buffers
+**/
+nled::RealTimeStatus nled::SetRealTimeSettings(const RealTimeSettings& inSettings)
+{
+	// Threads are configured when they start, stop all of them while the devices are idle
+	StopReconnectThread();
+	WaitForSubmittedFrames();
+	for(auto& v : sLedInterfaces)
+		StopOutputThread(*v.second);
+
+	nled::ApplyRealTimeSettings(inSettings);
+	nled::StartWorkers(nled::GetWorkerCount());
+	if(sOutputBackend == OutputBackend::Events && !nled::StartWriters(nled::GetWriterCount(), chrono::milliseconds(sSerialTimeout), IsWriteDue, StartWrite, FinishWrite, FailWrite, TimeOutWrite))
+		sOutputBackend = OutputBackend::Threads;
+
+	for(auto& v : sLedInterfaces)
+	{
+		nled::PrefaultConversionBuffers(*v.second);
+		StartOutputThread(*v.second);
+	}
+	if(sDisplaysInitialized)
+		StartReconnectThread();
+
+	// Report what isn't allowed
+	RealTimeStatus status = nled::GetRealTimeStatus();
+	if(status.mPriority < inSettings.mPriority)
+		cout << "WARNING: unable to set real time priority " << inSettings.mPriority << ", output threads run at " << (status.mPriority > 0 ? to_string(status.mPriority) : string("default priority")) << "\n";
+	if(inSettings.mOutputCpus != 0 && !status.mOutputPinned)
+		cout << "WARNING: unable to pin the output threads to the requested cpus\n";
+	if(inSettings.mConversionCpus != 0 && !status.mConversionPinned)
+		cout << "WARNING: unable to pin the conversion threads to the requested cpus\n";
+	if(inSettings.mLockMemory && !status.mMemoryLocked)
+		cout << "WARNING: unable to lock all memory, " << (status.mBuffersLocked ? "locked the frame buffers only" : "frame buffers are prefaulted but not locked") << "\n";
+	return status;
+}
@@ -0,0 +1,1180 @@
+#include <nledconversion.h>
+
+// Conversion kernels
+#include <nledtranspose.h>
+
+// Worker threads
+#include <nledworkers.h>
+
+// Memory locking
+#include <nledrealtime.h>
+
+// Standard Includes
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include <thread>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+// Statics local to this module
+//////////////////////////////////////////////////////////////////////////
+static unsigned char*			sGammaTable(nullptr);						//< Will hold the gamma table
+static unsigned long long*		sBitPlaneTable(nullptr);					//< Gamma corrected, bit spread contribution of a color value for every pin
+static nled::TransposeKernel	sTransposeKernel(nled::TransposeKernel::Scalar);	//< Bit transpose kernel selected for this cpu
+static nled::ConversionEngine	sConversionEngine(nled::ConversionEngine::Scalar);	//< Engine used to convert display data
+static nled::DirtyTracking		sDirtyTracking(nled::DirtyTracking::Off);	//< How changed display rows are detected
+static int						sConversionThreads(0);						//< Amount of threads that convert a single device, 0 selects one per core
+const static int				sMinLedsPerChunk(4096);						//< Smallest amount of leds converted by a single thread
+const static unsigned int		sGatherPanelTwo(0x80000000);				//< Gather entry bit that selects the second panel
+const static unsigned int		sGatherOffsetMask(0x7FFFFFFF);				//< Gather entry bits that hold the panel byte offset
+
+
+//////////////////////////////////////////////////////////////////////////
+// Module specific functionality
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Converts a packed rgb color in to a led compatible data format
+**/
+static int GetColorWiring(int c) 
+{
+	int red =	(c & 0xFF0000) >> 16;
+	int green = (c & 0x00FF00) >> 8;
+	int blue =	(c & 0x0000FF);
+	
+	red =	sGammaTable[red];
+	green = sGammaTable[green];
+	blue =	sGammaTable[blue];
+
+	return (green << 16) | (red << 8) | (blue);		// GRB - most common wiring
+}
+
+
+
+/**
+@brief Fills the first 3 bytes of a frame with sync info, the sync pulse is derived from the target frame rate
+**/
+void nled::WriteSyncHeader(const NLedDevice& inDevice, unsigned char* outFrame)
+{
+	outFrame[0] = inDevice.mSyncSlave ? '%' : '*';	// slaves wait for the frame sync pulse of the master
+	int usec = (int)((1000000.0 / nled::GetTargetFrameRate()) * 0.75);
+	usec = usec > 0xFFFF ? 0xFFFF : usec;
+	outFrame[1] = (unsigned char)(usec);		// request the frame sync pulse
+	outFrame[2] = (unsigned char)(usec >> 8);	// at 75% of the frame time
+}
+
+
+
+/**
+@brief Converts the char data of every panel in to led led data streams, for inRowCount strip rows starting at inFirstRow
+
+Scalar reference implementation, samples and wires every pixel before spreading the bits one by one
+**/
+static void PixelsToLedScalar(NLedDevice* inDevice, int inFirstRow, int inRowCount)
+{
+	int  width(inDevice->mStripLength);
+	int  height(inDevice->mLedHeight);
+	int  offset(sLedCharBufferOffset + (inFirstRow * width * 8 * sBytesPerLed));
+	int  pixel[8];
+	bool layout(inDevice->mLayout);
+	int  strips_per_pin(height / 8);
+
+	// Variables used in this loop
+	int x, y, xbegin, xend, xinc, mask;
+
+	// Holds the unsigned char data to be send over
+	unsigned char red(0);
+	unsigned char gre(0);
+	unsigned char blu(0);
+
+	// Where to sample from in the image
+	int image_index(-1);
+
+	// Calculate max index value
+	int  display_max_index = (inDevice->mStripLength * (inDevice->mLedHeight/2));
+
+	// For the amount of horizontal strips connected to a pin, iterate over every horizontal pixel
+	// Sample the color for that horizontal led on every pin (total number of 8)
+	for (y = inFirstRow; y < inFirstRow + inRowCount; y++) 
+	{
+		if ((y & 1) == (layout ? 0 : 1)) 
+		{
+			// even numbered rows are left to right
+			xbegin = 0;
+			xend = width;
+			xinc = 1;
+		} 
+		else 
+		{
+			// odd numbered rows are right to left
+			xbegin = width - 1;
+			xend = -1;
+			xinc = -1;
+		}
+
+		// Iterate over every horizontal pixel per strip and convert color data
+		for (x = xbegin; x != xend; x += xinc) 
+		{
+			for (int i=0; i < 8; i++) 
+			{
+				// Calculate image lookup index and sample color values
+				image_index = x + (y + strips_per_pin * i) * width;
+				unsigned char* image_data = image_index < display_max_index ?  inDevice->mRGBDataPanelOne : inDevice->mRGBDataPanelTwo;  
+				
+				// Remap image index based on sample display
+				image_index = image_index % display_max_index;
+				
+				red = image_data[(image_index * sBytesPerLed) + 0]; 
+				gre = image_data[(image_index * sBytesPerLed) + 1];
+				blu = image_data[(image_index * sBytesPerLed) + 2];
+
+				// Sample to int and update color wiring
+				pixel[i] = red<<16|gre<<8|blu<<0;
+				pixel[i] = GetColorWiring(pixel[i]);
+			}
+
+			// convert 8 pixels to 24 bytes (some black magic here)
+			for (mask = 0x800000; mask != 0; mask >>= 1) 
+			{
+				unsigned char b = 0;
+				for (int i=0; i < 8; i++) 
+				{
+					if ((pixel[i] & mask) != 0) b |= (1 << i);
+				}
+
+				inDevice->mConvertedData[offset++] = b;
+			}
+		}
+	}
+}
+
+
+
+/**
+@brief Maps a physical led position on a panel to the pixel index in the display data of that panel
+
+The physical position is relative to the panel, where x runs along the strip and y over the strips.
+Column major wiring is described by a 90 or 270 degree rotation, in which case the display data is transposed
+**/
+static int MapToDisplay(const nled::Topology& inTopology, int inX, int inY, int inPanelWidth, int inPanelHeight)
+{
+	int display_x(inX), display_y(inY);
+	int display_width(inPanelWidth), display_height(inPanelHeight);
+
+	switch(inTopology.mRotation)
+	{
+	case nled::Rotation::CW90:
+		display_x = inY;
+		display_y = inPanelWidth - 1 - inX;
+		display_width = inPanelHeight;
+		display_height = inPanelWidth;
+		break;
+	case nled::Rotation::CW180:
+		display_x = inPanelWidth - 1 - inX;
+		display_y = inPanelHeight - 1 - inY;
+		break;
+	case nled::Rotation::CW270:
+		display_x = inPanelHeight - 1 - inY;
+		display_y = inX;
+		display_width = inPanelHeight;
+		display_height = inPanelWidth;
+		break;
+	default:
+		break;
+	}
+
+	if(inTopology.mMirrorX)
+		display_x = display_width - 1 - display_x;
+	if(inTopology.mMirrorY)
+		display_y = display_height - 1 - display_y;
+
+	return (display_y * display_width) + display_x;
+}
+
+
+
+/**
+@brief Maps every display row of both panels to the strip rows that sample it
+
+Walks the gather index twice, once to count and once to fill, a strip row is only stored once per display row.
+Every strip row is flagged dirty, the next conversion covers the whole device
+**/
+static void BuildRowStripIndex(NLedDevice& ioDevice)
+{
+	int width(ioDevice.mStripLength);
+	int pins(ioDevice.mPinCount);
+	int strips_per_pin(ioDevice.mLedHeight / pins);
+	int panel_height(ioDevice.mLedHeight / 2);
+	bool transposed = ioDevice.mTopology.mRotation == nled::Rotation::CW90 || ioDevice.mTopology.mRotation == nled::Rotation::CW270;
+
+	// Display dimensions of a single panel
+	int display_width = transposed ? panel_height : width;
+	int display_rows = transposed ? width : panel_height;
+	int row_count = display_rows * 2;
+
+	vector<int>& offsets = ioDevice.mRowStripOffsets;
+	vector<int>& strips = ioDevice.mRowStrips;
+	vector<int> last_strip(row_count, -1);
+	offsets.assign(row_count + 1, 0);
+
+	for(int pass = 0; pass < 2; pass++)
+	{
+		// Second pass, turn counts in to offsets and use them as write cursors
+		vector<int> cursor;
+		if(pass == 1)
+		{
+			for(int r = 0; r < row_count; r++)
+				offsets[r + 1] += offsets[r];
+			strips.resize(offsets[row_count]);
+			cursor.assign(offsets.begin(), offsets.end() - 1);
+			last_strip.assign(row_count, -1);
+		}
+
+		const unsigned int* entry = ioDevice.mGatherIndex;
+		for(int y = 0; y < strips_per_pin; y++)
+		{
+			for(int n = 0; n < width * pins; n++)
+			{
+				unsigned int value = *entry++;
+				int pixel_index = (int)(value & sGatherOffsetMask) / ioDevice.mDisplayBytesPerLed;
+				int row = (pixel_index / display_width) + ((value >> 31) * display_rows);
+				if(last_strip[row] == y)
+					continue;
+
+				last_strip[row] = y;
+				if(pass == 0)
+					offsets[row + 1]++;
+				else
+					strips[cursor[row]++] = y;
+			}
+		}
+	}
+
+	ioDevice.mDirtyStrips.assign(strips_per_pin, 1);
+	ioDevice.mRowHashes.assign(row_count, 0);
+	ioDevice.mRowHashesValid = false;
+	ioDevice.mMarkedRows.assign(row_count, 0);
+	for(int i=0; i < sFrameSlotCount; i++)
+		ioDevice.mFrameRows[i].assign(row_count, 0);
+	ioDevice.mFrameValid = false;
+}
+
+
+
+/**
+@brief Builds the flat gather index of a device
+
+Holds one entry for every led in output order (strip row, strip column, pin).
+An entry holds the byte offset of the led color in the panel data, the top bit selects the second panel.
+The index only depends on geometry and topology, the conversion engines walk it linearly instead of recomputing it every frame.
+Because of that every topology converts as fast as the default serpentine wiring
+**/
+void nled::BuildGatherIndex(NLedDevice& ioDevice)
+{
+	int  width(ioDevice.mStripLength);
+	int  height(ioDevice.mLedHeight);
+	int  pins(ioDevice.mPinCount);
+	bool layout(ioDevice.mLayout);
+	bool serpentine(ioDevice.mTopology.mOrder == StripOrder::Serpentine);
+	int  strips_per_pin(height / pins);
+	int  panel_height(height / 2);
+
+	// Variables used in this loop
+	int x, y, xbegin, xend, xinc;
+
+	unsigned int* entry = ioDevice.mGatherIndex;
+	for (y = 0; y < strips_per_pin; y++) 
+	{
+		// The first strip on a pin runs left to right when layout is set,
+		// serpentine wiring flips direction on every following strip
+		bool left_to_right = serpentine ? (y & 1) == (layout ? 0 : 1) : layout;
+		if (left_to_right) 
+		{
+			xbegin = 0;
+			xend = width;
+			xinc = 1;
+		} 
+		else 
+		{
+			xbegin = width - 1;
+			xend = -1;
+			xinc = -1;
+		}
+
+		for (x = xbegin; x != xend; x += xinc) 
+		{
+			for (int i=0; i < pins; i++) 
+			{
+				// Strip row on the device, the first half belongs to panel one
+				int row = y + strips_per_pin * i;
+				unsigned int panel = row < panel_height ? 0 : sGatherPanelTwo;
+
+				int pixel_index = MapToDisplay(ioDevice.mTopology, x, row % panel_height, width, panel_height);
+				*entry++ = panel | (unsigned int)(pixel_index * ioDevice.mDisplayBytesPerLed);
+			}
+		}
+	}
+
+	BuildRowStripIndex(ioDevice);
+}
+
+
+
+/**
+@brief Returns if the scalar reference conversion can handle the device, it only knows 8 pins, RGB and the default wiring
+**/
+static bool SupportsScalarConversion(const NLedDevice& inDevice)
+{
+	const nled::Topology& topology = inDevice.mTopology;
+	return inDevice.mPinCount == 8 && inDevice.mPixelFormat == nled::PixelFormat::RGB && topology.mOrder == nled::StripOrder::Serpentine && topology.mRotation == nled::Rotation::None && !topology.mMirrorX && !topology.mMirrorY;
+}
+
+
+
+/**
+@brief How the display data of a device is sampled in to led colors, resolved at compile time
+**/
+enum PixelMode
+{
+	PixelModeRGB			= 0,			//< RGB display data to GRB leds
+	PixelModeRGBW			= 1,			//< RGBW display data to GRBW leds
+	PixelModeExtractWhite	= 2,			//< RGB display data to GRBW leds, white is the common part of RGB
+};
+
+
+
+/**
+@brief Returns the pixel mode of a device
+**/
+static PixelMode GetPixelMode(const NLedDevice& inDevice)
+{
+	if(inDevice.mPixelFormat == nled::PixelFormat::RGB)
+		return PixelModeRGB;
+	return inDevice.mExtractWhite ? PixelModeExtractWhite : PixelModeRGBW;
+}
+
+
+
+/**
+@brief Samples the colors of a single led from the display data, white is left untouched for RGB
+**/
+template<int Mode>
+static inline void SampleLed(const unsigned char* inColor, unsigned int& outRed, unsigned int& outGreen, unsigned int& outBlue, unsigned int& outWhite)
+{
+	outRed		= inColor[0];
+	outGreen	= inColor[1];
+	outBlue		= inColor[2];
+
+	if(Mode == PixelModeRGBW)
+	{
+		outWhite = inColor[3];
+	}
+	else if(Mode == PixelModeExtractWhite)
+	{
+		outWhite = outRed < outGreen ? outRed : outGreen;
+		outWhite = outBlue < outWhite ? outBlue : outWhite;
+		outRed	 -= outWhite;
+		outGreen -= outWhite;
+		outBlue	 -= outWhite;
+	}
+}
+
+
+
+/**
+@brief Converts inRowCount strip rows starting at inFirstRow in to led data streams using a vectorized bit transpose
+
+Every strip row is first gathered in to gamma corrected color planes (GRB(W), one byte per pin per color),
+after which the selected kernel transposes the planes in to the output stream in one go.
+The output is identical to the one produced by PixelsToLedScalar
+**/
+template<int Mode>
+static void PixelsToLedTransposed(NLedDevice* inDevice, int inFirstRow, int inRowCount)
+{
+	const int colors = Mode == PixelModeRGB ? 3 : 4;
+
+	int width(inDevice->mStripLength);
+	int pins(inDevice->mPinCount);
+	nled::TransposeFunction transpose = nled::GetTransposeFunction(sTransposeKernel, pins);
+
+	// Panel lookup, selected by the top bit of a gather entry
+	const unsigned char* panels[2] = { inDevice->mRGBDataPanelOne, inDevice->mRGBDataPanelTwo };
+	const unsigned int* gather = inDevice->mGatherIndex + (inFirstRow * width * pins);
+
+	// Amount of bytes a strip row occupies in the output stream, the color planes of a row take up the same amount
+	int row_size = width * pins * colors;
+	unsigned char* output = inDevice->mConvertedData + sLedCharBufferOffset + (inFirstRow * row_size);
+
+	// Every range gathers in to the planes of it's first row, ranges converted in parallel don't overlap
+	unsigned char* row_planes = inDevice->mPlaneData + (inFirstRow * row_size);
+
+	unsigned int red, gre, blu, wht(0);
+	for (int y = 0; y < inRowCount; y++) 
+	{
+		// Gather the gamma corrected colors of every pin in to GRB(W) planes
+		unsigned char* planes = row_planes;
+		for (int x = 0; x < width; x++) 
+		{
+			for (int i=0; i < pins; i++) 
+			{
+				unsigned int entry = *gather++;
+				SampleLed<Mode>(panels[entry >> 31] + (entry & sGatherOffsetMask), red, gre, blu, wht);
+
+				planes[i]				= sGammaTable[gre];
+				planes[i + pins]		= sGammaTable[red];
+				planes[i + (pins * 2)]	= sGammaTable[blu];
+				if(Mode != PixelModeRGB)
+					planes[i + (pins * 3)] = sGammaTable[wht];
+			}
+			planes += pins * colors;
+		}
+
+		// Transpose the planes of the entire row in to the output stream
+		transpose(row_planes, output, width * colors);
+		output += row_size;
+	}
+}
+
+
+
+/**
+@brief Bit plane table conversion for devices with 16 or 32 pins
+
+Every block of 8 pins is looked up the same way as PixelsToLedTable does,
+the bytes of the blocks are interleaved afterwards to form the pin words of every bit
+**/
+template<int Mode>
+static void PixelsToLedTableWide(NLedDevice* inDevice, int inFirstRow, int inRowCount)
+{
+	const int colors = Mode == PixelModeRGB ? 3 : 4;
+
+	int pins(inDevice->mPinCount);
+	int pin_bytes(pins / 8);
+	int first_led(inFirstRow * inDevice->mStripLength);
+	int led_count(inRowCount * inDevice->mStripLength);
+
+	// Panel lookup, selected by the top bit of a gather entry
+	const unsigned char* panels[2] = { inDevice->mRGBDataPanelOne, inDevice->mRGBDataPanelTwo };
+	const unsigned int* gather = inDevice->mGatherIndex + (first_led * pins);
+
+	// Where to write the next led to
+	unsigned char* output = inDevice->mConvertedData + sLedCharBufferOffset + (first_led * pins * colors);
+
+	// Bit spread colors for every block of 8 pins (GRB(W))
+	unsigned long long blocks[4][4];
+	unsigned char block_bytes[8];
+	unsigned int red, gre, blu, wht(0);
+
+	for (int n = 0; n < led_count; n++) 
+	{
+		for (int k = 0; k < pin_bytes; k++)
+		{
+			unsigned long long red_bits(0), gre_bits(0), blu_bits(0), wht_bits(0);
+			for (int i=0; i < 8; i++) 
+			{
+				unsigned int entry = *gather++;
+				SampleLed<Mode>(panels[entry >> 31] + (entry & sGatherOffsetMask), red, gre, blu, wht);
+
+				const unsigned long long* pin_table = sBitPlaneTable + (i * 256);
+				red_bits |= pin_table[red];
+				gre_bits |= pin_table[gre];
+				blu_bits |= pin_table[blu];
+				if(Mode != PixelModeRGB)
+					wht_bits |= pin_table[wht];
+			}
+			blocks[0][k] = gre_bits;
+			blocks[1][k] = red_bits;
+			blocks[2][k] = blu_bits;
+			blocks[3][k] = wht_bits;
+		}
+
+		// Interleave the blocks, byte k of a word holds block k
+		for (int c = 0; c < colors; c++)
+		{
+			for (int k = 0; k < pin_bytes; k++)
+			{
+				memcpy(block_bytes, &blocks[c][k], 8);
+				for (int j = 0; j < 8; j++)
+					output[(j * pin_bytes) + k] = block_bytes[j];
+			}
+			output += 8 * pin_bytes;
+		}
+	}
+}
+
+
+
+/**
+@brief Converts inRowCount strip rows starting at inFirstRow in to led data streams using the bit plane table
+
+Every color value maps directly to its gamma corrected, bit spread contribution for the pin it's sampled for.
+Converting 8 pixels comes down to 24 (32 for RGBW) table lookups and ORs, where every 8 byte lookup covers all the bits of one color.
+The output is identical to the one produced by PixelsToLedScalar
+**/
+template<int Mode>
+static void PixelsToLedTable(NLedDevice* inDevice, int inFirstRow, int inRowCount)
+{
+	const int colors = Mode == PixelModeRGB ? 3 : 4;
+
+	if(inDevice->mPinCount != 8)
+	{
+		PixelsToLedTableWide<Mode>(inDevice, inFirstRow, inRowCount);
+		return;
+	}
+
+	int first_led(inFirstRow * inDevice->mStripLength);
+	int led_count(inRowCount * inDevice->mStripLength);
+
+	// Panel lookup, selected by the top bit of a gather entry
+	const unsigned char* panels[2] = { inDevice->mRGBDataPanelOne, inDevice->mRGBDataPanelTwo };
+	const unsigned int* gather = inDevice->mGatherIndex + (first_led * 8);
+
+	// Where to write the next 24 (32) bytes to
+	unsigned char* output = inDevice->mConvertedData + sLedCharBufferOffset + (first_led * 8 * colors);
+
+	unsigned int red, gre, blu, wht(0);
+	for (int n = 0; n < led_count; n++) 
+	{
+		unsigned long long red_bits(0), gre_bits(0), blu_bits(0), wht_bits(0);
+		for (int i=0; i < 8; i++) 
+		{
+			unsigned int entry = *gather++;
+			SampleLed<Mode>(panels[entry >> 31] + (entry & sGatherOffsetMask), red, gre, blu, wht);
+
+			const unsigned long long* pin_table = sBitPlaneTable + (i * 256);
+			red_bits |= pin_table[red];
+			gre_bits |= pin_table[gre];
+			blu_bits |= pin_table[blu];
+			if(Mode != PixelModeRGB)
+				wht_bits |= pin_table[wht];
+		}
+
+		// GRB(W) - most common wiring
+		memcpy(output +  0, &gre_bits, 8);
+		memcpy(output +  8, &red_bits, 8);
+		memcpy(output + 16, &blu_bits, 8);
+		if(Mode != PixelModeRGB)
+			memcpy(output + 24, &wht_bits, 8);
+		output += 8 * colors;
+	}
+}
+
+
+
+/**
+@brief Starts the threads that help converting large devices, the thread that converts the device counts as one of them
+**/
+static void StartConversionWorkers()
+{
+	int thread_count = sConversionThreads > 0 ? sConversionThreads : (int)std::thread::hardware_concurrency();
+	nled::StartWorkers(thread_count > 1 ? thread_count - 1 : 0);
+}
+
+
+
+/**
+@brief Creates the gamma and bit plane tables and selects the transpose kernel
+**/
+void nled::InitConversion(float inGammaValue)
+{
+	ClearConversion();
+
+	// Create gamma table
+	sGammaTable = new unsigned char[256];
+	for(int i=0; i<256; i++)
+		sGammaTable[i] = (unsigned char)(pow((float)i / 255.0, inGammaValue) * 255.0f + 0.5);
+
+	// Create bit plane table, byte j of an entry holds bit (7-j) of the gamma corrected value at the bit of the pin
+	sBitPlaneTable = new unsigned long long[8 * 256];
+	for(int pin=0; pin<8; pin++)
+	{
+		for(int v=0; v<256; v++)
+		{
+			unsigned char bits[8];
+			for(int j=0; j<8; j++)
+				bits[j] = (unsigned char)(((sGammaTable[v] >> (7 - j)) & 1) << pin);
+			memcpy(&sBitPlaneTable[(pin * 256) + v], bits, 8);
+		}
+	}
+
+	// Select the bit transpose kernel
+	TransposeKernel kernel = GetBestTransposeKernel();
+	sTransposeKernel = kernel;
+
+	// Vector kernels outperform the table, without one the table is the fastest option
+	sConversionEngine = kernel == TransposeKernel::Scalar ? ConversionEngine::Table : ConversionEngine::Transpose;
+
+	StartConversionWorkers();
+}
+
+
+
+/**
+@brief Deletes the gamma and bit plane tables
+**/
+void nled::ClearConversion()
+{
+	StopWorkers();
+
+	delete[] sGammaTable;
+	delete[] sBitPlaneTable;
+	sGammaTable = nullptr;
+	sBitPlaneTable = nullptr;
+}
+
+
+
+/**
+@brief Creates the output buffers of a device, the device layout needs to be known
+**/
+void nled::CreateConversionBuffers(NLedDevice& ioDevice)
+{
+	// Create the container for the output buffer
+	ioDevice.mByteSize = (ioDevice.mLedHeight * ioDevice.mStripLength * ioDevice.mLedBytesPerLed) + sLedCharBufferOffset;
+	ioDevice.mConvertedData = new unsigned char[ioDevice.mByteSize];
+
+	// Create the container for the color planes (3 or 4 colors for every pin), a strip row for every strip row of the device.
+	// A row range only uses the planes of it's first row, any split of the rows in parallel ranges fits without overlap
+	ioDevice.mPlaneData = new unsigned char[ioDevice.mStripLength * ioDevice.mLedHeight * ioDevice.mLedBytesPerLed];
+
+	// Create the source offset for every led in output order
+	ioDevice.mGatherIndex = new unsigned int[ioDevice.mStripLength * (ioDevice.mLedHeight / ioDevice.mPinCount) * ioDevice.mPinCount];
+	BuildGatherIndex(ioDevice);
+
+	// Create the copy of the last frame send, used to skip unchanged frames
+	ioDevice.mSentData = new unsigned char[ioDevice.mByteSize];
+	ioDevice.mSentValid = false;
+
+	// Create the blackout frame, every bit of every led is off
+	ioDevice.mBlackData = new unsigned char[ioDevice.mByteSize];
+	memset(ioDevice.mBlackData, 0, ioDevice.mByteSize);
+	WriteSyncHeader(ioDevice, ioDevice.mBlackData);
+
+	// Create the slots submitted frames are copied to, both panels in one block
+	int panel_size = (ioDevice.mLedHeight / 2) * ioDevice.mStripLength * ioDevice.mDisplayBytesPerLed;
+	for(int i=0; i < sFrameSlotCount; i++)
+		ioDevice.mFrameData[i] = new unsigned char[panel_size * 2];
+	ioDevice.mFrameValid = false;
+
+	PrefaultConversionBuffers(ioDevice);
+}
+
+
+
+/**
+@brief Deletes the output buffers of a device, the buffers that were locked on their own are unlocked first
+**/
+void nled::DeleteConversionBuffers(NLedDevice& ioDevice)
+{
+	ReleaseBuffer(ioDevice.mConvertedData);
+	ReleaseBuffer(ioDevice.mPlaneData);
+	ReleaseBuffer(ioDevice.mGatherIndex);
+	ReleaseBuffer(ioDevice.mSentData);
+	ReleaseBuffer(ioDevice.mBlackData);
+	delete[] ioDevice.mConvertedData;
+	delete[] ioDevice.mPlaneData;
+	delete[] ioDevice.mGatherIndex;
+	delete[] ioDevice.mSentData;
+	delete[] ioDevice.mBlackData;
+	ioDevice.mConvertedData = nullptr;
+	ioDevice.mPlaneData = nullptr;
+	ioDevice.mGatherIndex = nullptr;
+	ioDevice.mSentData = nullptr;
+	ioDevice.mBlackData = nullptr;
+	ioDevice.mSentValid = false;
+
+	for(int i=0; i < sFrameSlotCount; i++)
+	{
+		ReleaseBuffer(ioDevice.mFrameData[i]);
+		delete[] ioDevice.mFrameData[i];
+		ioDevice.mFrameData[i] = nullptr;
+	}
+	ioDevice.mFrameValid = false;
+}
+
+
+
+/**
+@brief Touches and locks every buffer the output path writes, the first frame doesn't page fault
+**/
+void nled::PrefaultConversionBuffers(NLedDevice& ioDevice)
+{
+	int panel_size = (ioDevice.mLedHeight / 2) * ioDevice.mStripLength * ioDevice.mDisplayBytesPerLed;
+	PrefaultBuffer(ioDevice.mConvertedData, ioDevice.mByteSize);
+	PrefaultBuffer(ioDevice.mPlaneData, ioDevice.mStripLength * ioDevice.mLedHeight * ioDevice.mLedBytesPerLed);
+	PrefaultBuffer(ioDevice.mGatherIndex, ioDevice.mStripLength * (ioDevice.mLedHeight / ioDevice.mPinCount) * ioDevice.mPinCount * sizeof(unsigned int));
+	PrefaultBuffer(ioDevice.mSentData, ioDevice.mByteSize);
+	PrefaultBuffer(ioDevice.mBlackData, ioDevice.mByteSize);
+	for(int i=0; i < sFrameSlotCount; i++)
+		PrefaultBuffer(ioDevice.mFrameData[i], panel_size * 2);
+}
+
+
+
+/**
+@brief Sets the led color layout of a device and recreates the conversion buffers
+**/
+void nled::SetPixelFormat(NLedDevice& ioDevice, PixelFormat inFormat, bool inExtractWhite)
+{
+	ioDevice.mPixelFormat = inFormat;
+	ioDevice.mExtractWhite = inFormat == PixelFormat::RGBW && inExtractWhite;
+	ioDevice.mLedBytesPerLed = inFormat == PixelFormat::RGBW ? 4 : 3;
+	ioDevice.mDisplayBytesPerLed = inFormat == PixelFormat::RGBW && !ioDevice.mExtractWhite ? 4 : 3;
+
+	DeleteConversionBuffers(ioDevice);
+	CreateConversionBuffers(ioDevice);
+}
+
+
+
+/**
+@brief Converts inRowCount strip rows starting at inFirstRow using the given engine
+**/
+static void ConvertStripRowRange(NLedDevice* inDevice, nled::ConversionEngine inEngine, int inFirstRow, int inRowCount)
+{
+	PixelMode mode = GetPixelMode(*inDevice);
+	switch(inEngine)
+	{
+	case nled::ConversionEngine::Transpose:
+		if(mode == PixelModeRGB)
+			PixelsToLedTransposed<PixelModeRGB>(inDevice, inFirstRow, inRowCount);
+		else if(mode == PixelModeRGBW)
+			PixelsToLedTransposed<PixelModeRGBW>(inDevice, inFirstRow, inRowCount);
+		else
+			PixelsToLedTransposed<PixelModeExtractWhite>(inDevice, inFirstRow, inRowCount);
+		break;
+	case nled::ConversionEngine::Table:
+		if(mode == PixelModeRGB)
+			PixelsToLedTable<PixelModeRGB>(inDevice, inFirstRow, inRowCount);
+		else if(mode == PixelModeRGBW)
+			PixelsToLedTable<PixelModeRGBW>(inDevice, inFirstRow, inRowCount);
+		else
+			PixelsToLedTable<PixelModeExtractWhite>(inDevice, inFirstRow, inRowCount);
+		break;
+	default:
+		PixelsToLedScalar(inDevice, inFirstRow, inRowCount);
+		break;
+	}
+}
+
+
+
+/**
+@brief Range of strip rows split in to chunks that are converted in parallel
+**/
+struct ConversionChunks
+{
+	NLedDevice*				mDevice;
+	nled::ConversionEngine	mEngine;
+	int						mFirstRow;
+	int						mRowCount;
+	int						mChunkCount;
+};
+
+
+
+/**
+@brief Converts a single chunk, every chunk writes a disjoint part of the converted data and color planes
+**/
+static void ConvertChunk(void* inChunks, int inIndex)
+{
+	const ConversionChunks& chunks = *(const ConversionChunks*)inChunks;
+	int first_row = chunks.mFirstRow + ((chunks.mRowCount * inIndex) / chunks.mChunkCount);
+	int last_row = chunks.mFirstRow + ((chunks.mRowCount * (inIndex + 1)) / chunks.mChunkCount);
+	ConvertStripRowRange(chunks.mDevice, chunks.mEngine, first_row, last_row - first_row);
+}
+
+
+
+/**
+@brief Converts inRowCount strip rows starting at inFirstRow, large ranges are split over the worker threads
+**/
+static void ConvertStripRows(NLedDevice* inDevice, nled::ConversionEngine inEngine, int inFirstRow, int inRowCount)
+{
+	int row_leds = inDevice->mStripLength * inDevice->mPinCount;
+	int chunk_count = (inRowCount * row_leds) / sMinLedsPerChunk;
+	chunk_count = min(chunk_count, nled::GetWorkerCount() + 1);
+	chunk_count = min(chunk_count, inRowCount);
+
+	if(chunk_count <= 1)
+	{
+		ConvertStripRowRange(inDevice, inEngine, inFirstRow, inRowCount);
+		return;
+	}
+
+	ConversionChunks chunks = { inDevice, inEngine, inFirstRow, inRowCount, chunk_count };
+	nled::RunTasks(ConvertChunk, &chunks, chunk_count);
+}
+
+
+
+/**
+@brief Hashes the bytes of a single display row, 8 bytes at a time
+**/
+static unsigned long long HashRow(const unsigned char* inData, int inSize)
+{
+	unsigned long long hash(0xcbf29ce484222325ULL);
+	unsigned long long word;
+
+	int i(0);
+	for(; i + 8 <= inSize; i += 8)
+	{
+		memcpy(&word, inData + i, 8);
+		hash = (hash ^ word) * 0x100000001b3ULL;
+		hash ^= hash >> 29;
+	}
+
+	for(; i < inSize; i++)
+		hash = (hash ^ inData[i]) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+
+
+/**
+@brief Hashes every display row of the device and flags the strip rows of the rows that changed since the last conversion
+**/
+static void UpdateRowHashes(NLedDevice& ioDevice)
+{
+	int row_count = (int)ioDevice.mRowHashes.size();
+	int display_rows = row_count / 2;
+	int row_size = ((ioDevice.mStripLength * (ioDevice.mLedHeight / 2)) / display_rows) * ioDevice.mDisplayBytesPerLed;
+
+	for(int r = 0; r < row_count; r++)
+	{
+		const unsigned char* panel = r < display_rows ? ioDevice.mRGBDataPanelOne : ioDevice.mRGBDataPanelTwo;
+		unsigned long long hash = HashRow(panel + ((r % display_rows) * row_size), row_size);
+		if(ioDevice.mRowHashesValid && hash == ioDevice.mRowHashes[r])
+			continue;
+
+		ioDevice.mRowHashes[r] = hash;
+		for(int i = ioDevice.mRowStripOffsets[r]; i < ioDevice.mRowStripOffsets[r + 1]; i++)
+			ioDevice.mDirtyStrips[ioDevice.mRowStrips[i]] = 1;
+	}
+
+	ioDevice.mRowHashesValid = true;
+}
+
+
+
+/**
+@brief Flags the strip rows that need to be converted for the selected dirty tracking mode
+**/
+static void FlagChangedRows(NLedDevice* inDevice)
+{
+	switch(sDirtyTracking)
+	{
+	case nled::DirtyTracking::Off:
+		memset(inDevice->mDirtyStrips.data(), 1, inDevice->mDirtyStrips.size());
+		inDevice->mRowHashesValid = false;
+		break;
+	case nled::DirtyTracking::RowHash:
+		UpdateRowHashes(*inDevice);
+		break;
+	default:
+		break;
+	}
+}
+
+
+
+/**
+@brief Converts every run of consecutive dirty strip rows between inFirstRow and inLastRow in one go and clears the flags
+
+Returns if any strip row was converted
+**/
+static bool ConvertDirtyRows(NLedDevice* inDevice, nled::ConversionEngine inEngine, int inFirstRow, int inLastRow)
+{
+	unsigned char* dirty = inDevice->mDirtyStrips.data();
+	bool converted(false);
+
+	int y(inFirstRow);
+	while(y < inLastRow)
+	{
+		if(dirty[y] == 0)
+		{
+			y++;
+			continue;
+		}
+
+		int first_row(y);
+		while(y < inLastRow && dirty[y] != 0)
+			dirty[y++] = 0;
+		ConvertStripRows(inDevice, inEngine, first_row, y - first_row);
+		converted = true;
+	}
+	return converted;
+}
+
+
+
+/**
+@brief Converts the char data of every panel in to led data streams using the given engine
+
+The scalar reference only knows 8 pins, RGB and the default serpentine wiring, other devices use the table instead.
+Unless dirty tracking is off only the strip rows flagged dirty are converted, the others keep the data of the previous conversion.
+Returns if any strip row was converted, when not the led data is identical to the previous conversion
+**/
+bool PixelsToLed(NLedDevice* inDevice, nled::ConversionEngine inEngine)
+{
+	assert(sGammaTable != nullptr);
+	if(inEngine == nled::ConversionEngine::Scalar && !SupportsScalarConversion(*inDevice))
+		inEngine = nled::ConversionEngine::Table;
+
+	FlagChangedRows(inDevice);
+	bool converted = ConvertDirtyRows(inDevice, inEngine, 0, inDevice->mLedHeight / inDevice->mPinCount);
+
+	nled::WriteSyncHeader(*inDevice, inDevice->mConvertedData);
+	return converted;
+}
+
+
+
+/**
+@brief Converts the char data of every panel in to led data streams in chunks of whole strip rows
+
+The sync header is written first, after every chunk inChunkDone receives the amount of bytes at the start of the led data that are final.
+A chunk holds as many strip rows as fit in inChunkSize bytes, at least one
+**/
+bool PixelsToLed(NLedDevice* inDevice, nled::ConversionEngine inEngine, int inChunkSize, NLedChunkDone inChunkDone, void* inContext)
+{
+	assert(sGammaTable != nullptr);
+	if(inEngine == nled::ConversionEngine::Scalar && !SupportsScalarConversion(*inDevice))
+		inEngine = nled::ConversionEngine::Table;
+
+	int strips_per_pin(inDevice->mLedHeight / inDevice->mPinCount);
+	int row_size(inDevice->mStripLength * inDevice->mPinCount * inDevice->mLedBytesPerLed);
+	int rows_per_chunk = max(1, inChunkSize / row_size);
+
+	nled::WriteSyncHeader(*inDevice, inDevice->mConvertedData);
+	FlagChangedRows(inDevice);
+
+	bool converted(false);
+	for(int y = 0; y < strips_per_pin; y += rows_per_chunk)
+	{
+		int last_row = min(y + rows_per_chunk, strips_per_pin);
+		bool chunk_converted = ConvertDirtyRows(inDevice, inEngine, y, last_row);
+		converted = converted || chunk_converted;
+		inChunkDone(inDevice, sLedCharBufferOffset + (last_row * row_size), chunk_converted, inContext);
+	}
+	return converted;
+}
+
+
+
+/**
+@brief Converts the char data of every panel in to led data streams using the selected engine
+**/
+bool PixelsToLed(NLedDevice* inDevice)
+{
+	return PixelsToLed(inDevice, sConversionEngine);
+}
+
+
+
+/**
+@brief Selects the engine used to convert display data
+**/
+void nled::SetConversionEngine(ConversionEngine inEngine)
+{
+	sConversionEngine = inEngine;
+}
+
+
+
+/**
+@brief Returns the engine used to convert display data
+**/
+nled::ConversionEngine nled::GetConversionEngine()
+{
+	return sConversionEngine;
+}
+
+
+
+/**
+@brief Sets the amount of threads that convert a single device, restarts the worker threads when conversion is initialized
+**/
+void nled::SetConversionThreadCount(int inThreadCount)
+{
+	sConversionThreads = inThreadCount < 0 ? 0 : inThreadCount;
+	if(sGammaTable == nullptr)
+		return;
+
+	StartConversionWorkers();
+}
+
+
+
+/**
+@brief Returns the amount of threads that convert a single device
+**/
+int nled::GetConversionThreadCount()
+{
+	return GetWorkerCount() + 1;
+}
+
+
+
+/**
+@brief Selects how changed display rows are detected
+**/
+void nled::SetDirtyTracking(DirtyTracking inMode)
+{
+	sDirtyTracking = inMode;
+}
+
+
+
+/**
+@brief Returns how changed display rows are detected
+**/
+nled::DirtyTracking nled::GetDirtyTracking()
+{
+	return sDirtyTracking;
+}
+
+
+
+/**
+@brief Clamps a range of display rows of a panel and returns it as a range of rows of both panels
+**/
+static void GetRowRange(const NLedDevice& inDevice, int inPanel, int inFirstRow, int inRowCount, int& outFirstRow, int& outLastRow)
+{
+	int display_rows = (int)inDevice.mRowHashes.size() / 2;
+	int last_row = inRowCount < 0 ? display_rows : inFirstRow + inRowCount;
+	inFirstRow = inFirstRow < 0 ? 0 : inFirstRow;
+	last_row = last_row > display_rows ? display_rows : last_row;
+
+	outFirstRow = inFirstRow + (inPanel * display_rows);
+	outLastRow = last_row + (inPanel * display_rows);
+}
+
+
+
+/**
+@brief Flags the strip rows that sample inRowCount display rows starting at inFirstRow of a panel
+**/
+void nled::MarkRowsDirty(NLedDevice& ioDevice, int inPanel, int inFirstRow, int inRowCount)
+{
+	int first_row, last_row;
+	GetRowRange(ioDevice, inPanel, inFirstRow, inRowCount, first_row, last_row);
+
+	for(int r = first_row; r < last_row; r++)
+	{
+		for(int i = ioDevice.mRowStripOffsets[r]; i < ioDevice.mRowStripOffsets[r + 1]; i++)
+			ioDevice.mDirtyStrips[ioDevice.mRowStrips[i]] = 1;
+	}
+}
+
+
+
+/**
+@brief Flags inRowCount display rows starting at inFirstRow of a panel in ioRows, nothing is converted
+**/
+void nled::FlagRows(const NLedDevice& inDevice, vector<unsigned char>& ioRows, int inPanel, int inFirstRow, int inRowCount)
+{
+	int first_row, last_row;
+	GetRowRange(inDevice, inPanel, inFirstRow, inRowCount, first_row, last_row);
+
+	for(int r = first_row; r < last_row; r++)
+		ioRows[r] = 1;
+}
+
+
+
+/**
+@brief Flags the strip rows of every display row flagged in ioRows for conversion and clears the flags
+**/
+void nled::ApplyRowFlags(NLedDevice& ioDevice, vector<unsigned char>& ioRows)
+{
+	for(int r = 0; r < (int)ioRows.size(); r++)
+	{
+		if(ioRows[r] == 0)
+			continue;
+
+		ioRows[r] = 0;
+		for(int i = ioDevice.mRowStripOffsets[r]; i < ioDevice.mRowStripOffsets[r + 1]; i++)
+			ioDevice.mDirtyStrips[ioDevice.mRowStrips[i]] = 1;
+	}
+}
+
+
+
+/**
+@brief Copies the user data of both panels in to a frame slot
+
+Unless dirty tracking is off every row is compared against the previous slot while copying,
+rows that differ are flagged in the row flags of the slot together with the rows flagged by the application.
+The compare gives exact dirty rows for submitted frames, without hashing and without the application marking them
+**/
+void nled::SnapshotFrame(NLedDevice& ioDevice, int inSlot)
+{
+	int row_count = (int)ioDevice.mRowHashes.size();
+	int display_rows = row_count / 2;
+	int panel_size = (ioDevice.mLedHeight / 2) * ioDevice.mStripLength * ioDevice.mDisplayBytesPerLed;
+	int row_size = panel_size / display_rows;
+
+	unsigned char* slot = ioDevice.mFrameData[inSlot];
+	const unsigned char* previous = ioDevice.mFrameData[(inSlot + sFrameSlotCount - 1) % sFrameSlotCount];
+	vector<unsigned char>& rows = ioDevice.mFrameRows[inSlot];
+	bool compare = ioDevice.mFrameValid && sDirtyTracking != nled::DirtyTracking::Off;
+
+	for(int panel = 0; panel < 2; panel++)
+	{
+		// A panel without data, of a device that connected after the application set it's data, is black
+		const unsigned char* data = panel == 0 ? ioDevice.mUserDataPanelOne : ioDevice.mUserDataPanelTwo;
+		int offset = panel * panel_size;
+		if(!compare)
+		{
+			if(data != nullptr)
+				memcpy(slot + offset, data, panel_size);
+			else
+				memset(slot + offset, 0, panel_size);
+			continue;
+		}
+
+		for(int r = 0; r < display_rows; r++, offset += row_size)
+		{
+			if(data != nullptr)
+				memcpy(slot + offset, data + (r * row_size), row_size);
+			else
+				memset(slot + offset, 0, row_size);
+			if(memcmp(slot + offset, previous + offset, row_size) != 0)
+				rows[(panel * display_rows) + r] = 1;
+		}
+	}
+
+	// Without a valid previous slot every row changed
+	if(!compare)
+		memset(rows.data(), 1, row_count);
+
+	// Hand over the rows flagged by the application
+	for(int r = 0; r < row_count; r++)
+	{
+		rows[r] |= ioDevice.mMarkedRows[r];
+		ioDevice.mMarkedRows[r] = 0;
+	}
+
+	ioDevice.mFrameValid = true;
+}
+
+
+
+/**
+@brief Returns a human readable name for the engine
+**/
+const char* nled::GetConversionEngineName(ConversionEngine inEngine)
+{
+	switch(inEngine)
+	{
+	case ConversionEngine::Transpose:
+		return "Transpose";
+	case ConversionEngine::Table:
+		return "Table";
+	default:
+		return "Scalar";
+	}
+}
@@ -0,0 +1,242 @@
+#include <nledhotplug.h>
+
+// Serial Includes
+#include <serial/ww_serial.h>
+
+// Standard Includes
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#endif
+
+// Namespace
+using namespace std;
+
+#ifdef __linux__
+
+//////////////////////////////////////////////////////////////////////////
+// Statics local to this module
+//////////////////////////////////////////////////////////////////////////
+const static char*				sDevicePath("/dev");						//< Directory the ports are created in
+const static int				sSettleTime(100);							//< Time in milli seconds without events before a batch is handed over
+static thread					sWatcherThread;								//< Thread that waits for port events
+static int						sNotifyHandle(-1);							//< Inotify instance watching the device directory
+static int						sWakeHandle(-1);							//< Event descriptor, signaled to stop the watcher
+static nled::PortsChanged		sChanged(nullptr);							//< Called with every batch of changed ports
+
+
+//////////////////////////////////////////////////////////////////////////
+// Module specific functionality
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Adds a port to a batch, a port that disappears and comes back is reported in both lists
+**/
+static void AddPortEvent(const string& inPort, bool inAdded, vector<string>& ioAdded, vector<string>& ioRemoved)
+{
+	vector<string>::iterator added = find(ioAdded.begin(), ioAdded.end(), inPort);
+	if(inAdded)
+	{
+		if(added == ioAdded.end())
+			ioAdded.push_back(inPort);
+		return;
+	}
+
+	if(added != ioAdded.end())
+		ioAdded.erase(added);
+	if(find(ioRemoved.begin(), ioRemoved.end(), inPort) == ioRemoved.end())
+		ioRemoved.push_back(inPort);
+}
+
+
+
+/**
+@brief Reads all pending events of the inotify instance in to the batch
+
+When the event queue overflowed events were lost, every port that's present is reported as added then
+**/
+static void ReadPortEvents(vector<string>& ioAdded, vector<string>& ioRemoved)
+{
+	alignas(inotify_event) char buffer[4096];
+	bool overflow(false);
+	while(true)
+	{
+		ssize_t size = read(sNotifyHandle, buffer, sizeof(buffer));
+		if(size <= 0)
+			break;
+
+		for(char* data = buffer; data < buffer + size; )
+		{
+			const inotify_event* event = (const inotify_event*)data;
+			data += sizeof(inotify_event) + event->len;
+			if(event->mask & IN_Q_OVERFLOW)
+				overflow = true;
+			if(event->len == 0)
+				continue;
+
+			string port = string(sDevicePath) + "/" + event->name;
+			AddPortEvent(port, (event->mask & (IN_CREATE | IN_ATTRIB | IN_MOVED_TO)) != 0, ioAdded, ioRemoved);
+		}
+	}
+
+	if(!overflow)
+		return;
+
+	cout << "WARNING: port events were lost, rescanning all ports\n";
+	for(const serial::PortInfo& p : serial::list_ports())
+		AddPortEvent(p.port, true, ioAdded, ioRemoved);
+}
+
+
+
+/**
+@brief Watcher thread, collects events until the device directory settles and hands them over
+**/
+static void RunWatcher()
+{
+	pollfd handles[2];
+	handles[0].fd = sNotifyHandle;
+	handles[0].events = POLLIN;
+	handles[1].fd = sWakeHandle;
+	handles[1].events = POLLIN;
+
+	vector<string> added;
+	vector<string> removed;
+	while(true)
+	{
+		// Wait for the first event without a timeout, after that until no events arrive for a while
+		bool collecting = !added.empty() || !removed.empty();
+		int count = poll(handles, 2, collecting ? sSettleTime : -1);
+		if(count < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			cout << "ERROR: unable to wait for port events, " << strerror(errno) << "\n";
+			return;
+		}
+		if(handles[1].revents != 0)
+			return;
+
+		if(count > 0)
+		{
+			ReadPortEvents(added, removed);
+			continue;
+		}
+
+		if(collecting)
+		{
+			sChanged(added, removed);
+			added.clear();
+			removed.clear();
+		}
+	}
+}
+
+
+
+/**
+@brief Closes the descriptors of the watcher
+**/
+static void CloseWatcher()
+{
+	if(sNotifyHandle >= 0)
+		close(sNotifyHandle);
+	if(sWakeHandle >= 0)
+		close(sWakeHandle);
+	sNotifyHandle = -1;
+	sWakeHandle = -1;
+}
+
+
+
+/**
+@brief Returns if the port watcher is available on this platform
+**/
+bool nled::IsPortWatcherSupported()
+{
+	return true;
+}
+
+
+
+/**
+@brief Starts watching the device directory for ports
+**/
+bool nled::StartPortWatcher(PortsChanged inChanged)
+{
+	StopPortWatcher();
+
+	sNotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	sWakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(sNotifyHandle < 0 || sWakeHandle < 0 || inotify_add_watch(sNotifyHandle, sDevicePath, IN_CREATE | IN_ATTRIB | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM) < 0)
+	{
+		cout << "ERROR: unable to watch " << sDevicePath << " for ports, " << strerror(errno) << "\n";
+		CloseWatcher();
+		return false;
+	}
+
+	sChanged = inChanged;
+	sWatcherThread = thread(RunWatcher);
+	return true;
+}
+
+
+
+/**
+@brief Stops watching for ports
+**/
+void nled::StopPortWatcher()
+{
+	if(!sWatcherThread.joinable())
+		return;
+
+	uint64_t value(1);
+	if(write(sWakeHandle, &value, sizeof(value)) < 0)
+		cout << "WARNING: unable to stop port watcher\n";
+	sWatcherThread.join();
+	CloseWatcher();
+}
+
+
+
+/**
+@brief Returns if the port watcher is running
+**/
+bool nled::IsPortWatcherRunning()
+{
+	return sWatcherThread.joinable();
+}
+
+#else
+
+/**
+@brief The port watcher needs inotify, ports are only found by InitDisplays
+**/
+bool nled::IsPortWatcherSupported()
+{
+	return false;
+}
+
+bool nled::StartPortWatcher(PortsChanged inChanged)
+{
+	return false;
+}
+
+void nled::StopPortWatcher()
+{
+}
+
+bool nled::IsPortWatcherRunning()
+{
+	return false;
+}
+
+#endif
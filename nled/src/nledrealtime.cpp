@@ -0,0 +1,299 @@
+#include <nledrealtime.h>
+
+// Standard Includes
+#include <thread>
+#include <mutex>
+#include <map>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+// Namespace
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////
+// Statics local to this module
+//////////////////////////////////////////////////////////////////////////
+const static size_t				sPageSize(4096);							//< Smallest page size, buffers are touched at this stride
+static nled::RealTimeSettings	sSettings;									//< Requested settings
+static nled::RealTimeStatus		sStatus;									//< What the threads and buffers configured since the settings were applied got
+static mutex					sStatusMutex;								//< Guards the status and the locked buffers
+static map<void*, size_t>		sLockedBuffers;								//< Buffers locked on their own and their size, unlocked when they're released
+
+
+//////////////////////////////////////////////////////////////////////////
+// Module specific functionality
+//////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+
+/**
+@brief Windows has no real time policy, the requested priority maps to time critical
+**/
+static int SetPriority(thread& ioThread, int inPriority)
+{
+	return SetThreadPriority(ioThread.native_handle(), THREAD_PRIORITY_TIME_CRITICAL) ? inPriority : 0;
+}
+
+static bool SetCpus(thread& ioThread, unsigned long long inCpus)
+{
+	return SetThreadAffinityMask(ioThread.native_handle(), (DWORD_PTR)inCpus) != 0;
+}
+
+static bool LockAllMemory()
+{
+	return false;
+}
+
+static void UnlockAllMemory()
+{
+}
+
+static bool LockBuffer(void* inData, size_t inSize)
+{
+	return VirtualLock(inData, inSize) != 0;
+}
+
+static void UnlockBuffer(void* inData, size_t inSize)
+{
+	VirtualUnlock(inData, inSize);
+}
+
+#elif defined(__linux__)
+
+/**
+@brief Switches a thread to SCHED_FIFO, returns the priority it got
+
+Without the privilege the priority is lowered to the real time limit of the process, without a limit it keeps the default scheduling
+**/
+static int SetPriority(thread& ioThread, int inPriority)
+{
+	sched_param param;
+	param.sched_priority = inPriority;
+	if(pthread_setschedparam(ioThread.native_handle(), SCHED_FIFO, &param) == 0)
+		return inPriority;
+
+	rlimit limit;
+	if(getrlimit(RLIMIT_RTPRIO, &limit) != 0 || limit.rlim_cur == 0 || limit.rlim_cur >= (rlim_t)inPriority)
+		return 0;
+
+	param.sched_priority = (int)limit.rlim_cur;
+	return pthread_setschedparam(ioThread.native_handle(), SCHED_FIFO, &param) == 0 ? param.sched_priority : 0;
+}
+
+
+
+/**
+@brief Pins a thread to a set of cpus, one bit per cpu
+**/
+static bool SetCpus(thread& ioThread, unsigned long long inCpus)
+{
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	for(int i=0; i<64; i++)
+	{
+		if(inCpus & (1ULL << i))
+			CPU_SET(i, &cpus);
+	}
+	return pthread_setaffinity_np(ioThread.native_handle(), sizeof(cpus), &cpus) == 0;
+}
+
+
+
+/**
+@brief Locks all current and future memory of the process
+**/
+static bool LockAllMemory()
+{
+	return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+}
+
+
+
+static void UnlockAllMemory()
+{
+	munlockall();
+}
+
+
+
+/**
+@brief Locks the pages of a single buffer, they stay locked when the buffer is freed and reused by the heap until they're unlocked
+**/
+static bool LockBuffer(void* inData, size_t inSize)
+{
+	return mlock(inData, inSize) == 0;
+}
+
+
+
+static void UnlockBuffer(void* inData, size_t inSize)
+{
+	munlock(inData, inSize);
+}
+
+#else
+
+/**
+@brief Real time settings aren't supported on this platform
+**/
+static int SetPriority(thread& ioThread, int inPriority)
+{
+	return 0;
+}
+
+static bool SetCpus(thread& ioThread, unsigned long long inCpus)
+{
+	return false;
+}
+
+static bool LockAllMemory()
+{
+	return false;
+}
+
+static void UnlockAllMemory()
+{
+}
+
+static bool LockBuffer(void* inData, size_t inSize)
+{
+	return false;
+}
+
+static void UnlockBuffer(void* inData, size_t inSize)
+{
+}
+
+#endif
+
+
+
+/**
+@brief Unlocks all buffers locked on their own, call with the status lock held
+**/
+static void UnlockBuffers()
+{
+	for(auto& v : sLockedBuffers)
+		UnlockBuffer(v.first, v.second);
+	sLockedBuffers.clear();
+}
+
+
+
+/**
+@brief Stores the settings and locks or unlocks all memory, the buffers locked on their own are unlocked
+**/
+void nled::ApplyRealTimeSettings(const RealTimeSettings& inSettings)
+{
+	lock_guard<mutex> lock(sStatusMutex);
+	bool was_locked = sStatus.mMemoryLocked;
+	UnlockBuffers();
+
+	sSettings = inSettings;
+	sStatus = RealTimeStatus();
+	sStatus.mPriority = inSettings.mPriority;
+	sStatus.mOutputPinned = inSettings.mOutputCpus != 0;
+	sStatus.mConversionPinned = inSettings.mConversionCpus != 0;
+
+	if(inSettings.mLockMemory)
+	{
+		sStatus.mMemoryLocked = was_locked || LockAllMemory();
+		sStatus.mBuffersLocked = true;
+	}
+	else if(was_locked)
+	{
+		UnlockAllMemory();
+	}
+}
+
+
+
+/**
+@brief Applies the priority and cpus of the role to a started thread
+**/
+void nled::ConfigureThread(std::thread& ioThread, ThreadRole inRole)
+{
+	lock_guard<mutex> lock(sStatusMutex);
+	if(sSettings.mPriority > 0)
+		sStatus.mPriority = min(sStatus.mPriority, SetPriority(ioThread, sSettings.mPriority));
+
+	unsigned long long cpus = inRole == ThreadRole::Output ? sSettings.mOutputCpus : sSettings.mConversionCpus;
+	if(cpus == 0 || SetCpus(ioThread, cpus))
+		return;
+
+	if(inRole == ThreadRole::Output)
+		sStatus.mOutputPinned = false;
+	else
+		sStatus.mConversionPinned = false;
+}
+
+
+
+/**
+@brief Touches every page of a buffer and locks it when all memory isn't locked
+**/
+void nled::PrefaultBuffer(void* ioData, size_t inSize)
+{
+	if(!sSettings.mLockMemory || ioData == nullptr || inSize == 0)
+		return;
+
+	volatile unsigned char* data = (volatile unsigned char*)ioData;
+	for(size_t i=0; i < inSize; i += sPageSize)
+		data[i] = data[i];
+	data[inSize - 1] = data[inSize - 1];
+
+	// Every buffer is only locked once, it's unlocked with ReleaseBuffer
+	lock_guard<mutex> lock(sStatusMutex);
+	if(sStatus.mMemoryLocked || sLockedBuffers.count(ioData) > 0)
+		return;
+	if(LockBuffer(ioData, inSize))
+		sLockedBuffers[ioData] = inSize;
+	else
+		sStatus.mBuffersLocked = false;
+}
+
+
+
+/**
+@brief Unlocks a buffer that's about to be freed, when it was locked on it's own
+**/
+void nled::ReleaseBuffer(void* ioData)
+{
+	lock_guard<mutex> lock(sStatusMutex);
+	map<void*, size_t>::iterator locked = sLockedBuffers.find(ioData);
+	if(locked == sLockedBuffers.end())
+		return;
+
+	UnlockBuffer(locked->first, locked->second);
+	sLockedBuffers.erase(locked);
+}
+
+
+
+/**
+@brief Returns the requested real time settings
+**/
+nled::RealTimeSettings nled::GetRealTimeSettings()
+{
+	return sSettings;
+}
+
+
+
+/**
+@brief Returns what the library threads and memory got
+**/
+nled::RealTimeStatus nled::GetRealTimeStatus()
+{
+	lock_guard<mutex> lock(sStatusMutex);
+	return sStatus;
+}
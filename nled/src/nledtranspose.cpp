@@ -0,0 +1,510 @@
+#include <nledtranspose.h>
+
+// Standard Includes
+#include <assert.h>
+
+// Platform Includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define NLED_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+// Kernels that need more than SSE2 are compiled with a per function target on gcc / clang,
+// msvc accepts the intrinsics without any additional flags
+#if defined(__GNUC__)
+	#define NLED_TARGET(inTarget) __attribute__((target(inTarget)))
+#else
+	#define NLED_TARGET(inTarget)
+#endif
+
+// GFNI intrinsics are only available from msvc 2019 onwards
+#if defined(NLED_X86) && (defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1920))
+	#define NLED_GFNI_KERNEL
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Kernels
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Portable 8x8 transpose, used as fallback and to handle the groups the vector kernels leave behind
+**/
+static void Transpose8Scalar(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	for(int g = 0; g < inGroupCount; g++)
+	{
+		// Pack the 8 plane bytes, byte i holds pin i
+		unsigned long long v(0);
+		for(int i = 0; i < 8; i++)
+			v |= (unsigned long long)inPlanes[i] << (i * 8);
+
+		// Isolate the bit for every pin and gather them in the top byte
+		for(int j = 0; j < 8; j++)
+			outBits[j] = (unsigned char)((((v >> (7 - j)) & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+
+		inPlanes += 8;
+		outBits += 8;
+	}
+}
+
+
+/**
+@brief Portable transpose for 16 and 32 pins, transposes every block of 8 pins and interleaves the results
+**/
+static void TransposeWideScalar(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount, int inPinCount)
+{
+	int pin_bytes = inPinCount / 8;
+	unsigned char block[8];
+	for(int g = 0; g < inGroupCount; g++)
+	{
+		for(int k = 0; k < pin_bytes; k++)
+		{
+			Transpose8Scalar(inPlanes + (k * 8), block, 1);
+			for(int j = 0; j < 8; j++)
+				outBits[(j * pin_bytes) + k] = block[j];
+		}
+
+		inPlanes += inPinCount;
+		outBits += inPinCount;
+	}
+}
+
+static void Transpose16Scalar(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	TransposeWideScalar(inPlanes, outBits, inGroupCount, 16);
+}
+
+static void Transpose32Scalar(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	TransposeWideScalar(inPlanes, outBits, inGroupCount, 32);
+}
+
+
+#ifdef NLED_X86
+
+/**
+@brief Collects the msb of every byte for all 8 bits, word j of the result holds the movemask of bit (7-j)
+**/
+NLED_TARGET("sse2")
+static inline __m128i MoveMaskBits(__m128i v)
+{
+	__m128i w = _mm_setzero_si128();
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 0); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 1); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 2); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 3); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 4); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 5); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 6); v = _mm_add_epi8(v, v);
+	w = _mm_insert_epi16(w, _mm_movemask_epi8(v), 7);
+	return w;
+}
+
+
+/**
+@brief SSE2 transpose, moves the bit for every pin out using movemask, 2 groups at a time
+**/
+NLED_TARGET("sse2")
+static void Transpose8SSE2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	const __m128i low_mask = _mm_set1_epi16(0x00FF);
+
+	int g(0);
+	for(; g + 2 <= inGroupCount; g += 2)
+	{
+		// Every word holds the output byte for both groups
+		__m128i w = MoveMaskBits(_mm_loadu_si128((const __m128i*)(inPlanes + g * 8)));
+
+		// Split the words in to the bytes of the first and second group
+		__m128i out = _mm_packus_epi16(_mm_and_si128(w, low_mask), _mm_srli_epi16(w, 8));
+		_mm_storeu_si128((__m128i*)(outBits + g * 8), out);
+	}
+
+	Transpose8Scalar(inPlanes + g * 8, outBits + g * 8, inGroupCount - g);
+}
+
+
+/**
+@brief SSE2 transpose for 16 pins, the movemask words are the output words
+**/
+NLED_TARGET("sse2")
+static void Transpose16SSE2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	for(int g = 0; g < inGroupCount; g++)
+	{
+		__m128i w = MoveMaskBits(_mm_loadu_si128((const __m128i*)(inPlanes + g * 16)));
+		_mm_storeu_si128((__m128i*)(outBits + g * 16), w);
+	}
+}
+
+
+/**
+@brief SSE2 transpose for 32 pins, combines the movemask words of the lower and upper 16 pins
+**/
+NLED_TARGET("sse2")
+static void Transpose32SSE2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	for(int g = 0; g < inGroupCount; g++)
+	{
+		__m128i low  = MoveMaskBits(_mm_loadu_si128((const __m128i*)(inPlanes + g * 32)));
+		__m128i high = MoveMaskBits(_mm_loadu_si128((const __m128i*)(inPlanes + g * 32 + 16)));
+		_mm_storeu_si128((__m128i*)(outBits + g * 32), _mm_unpacklo_epi16(low, high));
+		_mm_storeu_si128((__m128i*)(outBits + g * 32 + 16), _mm_unpackhi_epi16(low, high));
+	}
+}
+
+
+/**
+@brief Collects the msb of every byte for all 8 bits, dword j of the result holds the movemask of bit (7-j)
+**/
+NLED_TARGET("avx2")
+static inline __m256i MoveMaskBits(__m256i v)
+{
+	int m0 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m1 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m2 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m3 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m4 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m5 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m6 = _mm256_movemask_epi8(v); v = _mm256_add_epi8(v, v);
+	int m7 = _mm256_movemask_epi8(v);
+	return _mm256_setr_epi32(m0, m1, m2, m3, m4, m5, m6, m7);
+}
+
+
+/**
+@brief AVX2 transpose, 4 groups at a time
+**/
+NLED_TARGET("avx2")
+static void Transpose8AVX2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	// Orders the movemask bytes per group within a lane, after which the lanes are interleaved
+	const __m256i group_shuffle = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+												   0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m256i lane_permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	int g(0);
+	for(; g + 4 <= inGroupCount; g += 4)
+	{
+		__m256i w = MoveMaskBits(_mm256_loadu_si256((const __m256i*)(inPlanes + g * 8)));
+		w = _mm256_shuffle_epi8(w, group_shuffle);
+		w = _mm256_permutevar8x32_epi32(w, lane_permute);
+		_mm256_storeu_si256((__m256i*)(outBits + g * 8), w);
+	}
+
+	Transpose8SSE2(inPlanes + g * 8, outBits + g * 8, inGroupCount - g);
+}
+
+
+/**
+@brief AVX2 transpose for 16 pins, 2 groups at a time
+**/
+NLED_TARGET("avx2")
+static void Transpose16AVX2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	// Every dword holds a word of both groups, order them per group within a lane and interleave the lanes
+	const __m256i group_shuffle = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+												   0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+	int g(0);
+	for(; g + 2 <= inGroupCount; g += 2)
+	{
+		__m256i w = MoveMaskBits(_mm256_loadu_si256((const __m256i*)(inPlanes + g * 16)));
+		w = _mm256_shuffle_epi8(w, group_shuffle);
+		w = _mm256_permute4x64_epi64(w, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)(outBits + g * 16), w);
+	}
+
+	Transpose16SSE2(inPlanes + g * 16, outBits + g * 16, inGroupCount - g);
+}
+
+
+/**
+@brief AVX2 transpose for 32 pins, the movemask dwords are the output dwords
+**/
+NLED_TARGET("avx2")
+static void Transpose32AVX2(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	for(int g = 0; g < inGroupCount; g++)
+	{
+		__m256i w = MoveMaskBits(_mm256_loadu_si256((const __m256i*)(inPlanes + g * 32)));
+		_mm256_storeu_si256((__m256i*)(outBits + g * 32), w);
+	}
+}
+
+#endif // NLED_X86
+
+
+#ifdef NLED_GFNI_KERNEL
+
+/**
+@brief Transposes every qword (8 pins) of v in to the 8 output bytes of those pins
+
+Every qword is used as the bit matrix of an affine transform,
+multiplying it with a single bit vector selects one bit of every pin.
+The bytes are reversed first because the matrix rows are stored last to first
+**/
+NLED_TARGET("avx512f,avx512bw,gfni")
+static inline __m512i AffineTranspose(__m512i v)
+{
+	const __m512i reverse = _mm512_set_epi8(
+		8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+		8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+		8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+		8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+	const __m512i bit_select = _mm512_set1_epi64(0x0102040810204080LL);
+
+	return _mm512_gf2p8affine_epi64_epi8(bit_select, _mm512_shuffle_epi8(v, reverse), 0);
+}
+
+
+/**
+@brief GFNI transpose, 8 groups at a time
+**/
+NLED_TARGET("avx512f,avx512bw,gfni")
+static void Transpose8GFNI(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	int g(0);
+	for(; g + 8 <= inGroupCount; g += 8)
+	{
+		__m512i v = _mm512_loadu_si512((const void*)(inPlanes + g * 8));
+		_mm512_storeu_si512((void*)(outBits + g * 8), AffineTranspose(v));
+	}
+
+	Transpose8AVX2(inPlanes + g * 8, outBits + g * 8, inGroupCount - g);
+}
+
+
+/**
+@brief GFNI transpose for 16 pins, 4 groups at a time
+
+The bytes of both 8 pin blocks of a group end up in the same 128 bit lane and are interleaved in to words
+**/
+NLED_TARGET("avx512f,avx512bw,gfni")
+static void Transpose16GFNI(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	const __m512i interleave = _mm512_set_epi8(
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0);
+
+	int g(0);
+	for(; g + 4 <= inGroupCount; g += 4)
+	{
+		__m512i v = _mm512_loadu_si512((const void*)(inPlanes + g * 16));
+		_mm512_storeu_si512((void*)(outBits + g * 16), _mm512_shuffle_epi8(AffineTranspose(v), interleave));
+	}
+
+	Transpose16AVX2(inPlanes + g * 16, outBits + g * 16, inGroupCount - g);
+}
+
+
+/**
+@brief GFNI transpose for 32 pins, 2 groups at a time
+
+The bytes of pin blocks 0-1 and 2-3 are interleaved in to words within their lane,
+after which the words of both lanes of a group are interleaved in to dwords
+**/
+NLED_TARGET("avx512f,avx512bw,gfni")
+static void Transpose32GFNI(const unsigned char* inPlanes, unsigned char* outBits, int inGroupCount)
+{
+	const __m512i interleave = _mm512_set_epi8(
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0);
+	const __m512i word_interleave = _mm512_set_epi16(
+		31, 23, 30, 22, 29, 21, 28, 20, 27, 19, 26, 18, 25, 17, 24, 16,
+		15,  7, 14,  6, 13,  5, 12,  4, 11,  3, 10,  2,  9,  1,  8,  0);
+
+	int g(0);
+	for(; g + 2 <= inGroupCount; g += 2)
+	{
+		__m512i v = _mm512_loadu_si512((const void*)(inPlanes + g * 32));
+		v = _mm512_shuffle_epi8(AffineTranspose(v), interleave);
+		_mm512_storeu_si512((void*)(outBits + g * 32), _mm512_permutexvar_epi16(word_interleave, v));
+	}
+
+	Transpose32AVX2(inPlanes + g * 32, outBits + g * 32, inGroupCount - g);
+}
+
+#endif // NLED_GFNI_KERNEL
+
+
+//////////////////////////////////////////////////////////////////////////
+// Cpu detection
+//////////////////////////////////////////////////////////////////////////
+
+#ifdef NLED_X86
+
+/**
+@brief Queries cpu information for the given leaf
+**/
+static void GetCpuId(int inLeaf, int inSubLeaf, unsigned int outRegisters[4])
+{
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuidex(regs, inLeaf, inSubLeaf);
+	for(int i = 0; i < 4; i++)
+		outRegisters[i] = (unsigned int)regs[i];
+#else
+	__cpuid_count(inLeaf, inSubLeaf, outRegisters[0], outRegisters[1], outRegisters[2], outRegisters[3]);
+#endif
+}
+
+
+/**
+@brief Returns which register states the os saves on a context switch
+**/
+static unsigned long long GetEnabledRegisterStates()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+	__asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((unsigned long long)high << 32) | low;
+#endif
+}
+
+
+/**
+@brief Detects the fastest kernel the cpu and operating system support
+**/
+static nled::TransposeKernel DetectTransposeKernel()
+{
+	unsigned int regs[4];
+	GetCpuId(0, 0, regs);
+	unsigned int max_leaf = regs[0];
+
+	GetCpuId(1, 0, regs);
+	bool sse2 = (regs[3] & (1u << 26)) != 0;
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool avx = (regs[2] & (1u << 28)) != 0;
+
+	if(!sse2)
+		return nled::TransposeKernel::Scalar;
+
+	// Wide registers are only usable when the os saves their state
+	unsigned long long xcr0 = osxsave ? GetEnabledRegisterStates() : 0;
+	bool ymm_state = (xcr0 & 0x06) == 0x06;
+	bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+	bool avx2(false), avx512bw(false), gfni(false);
+	if(max_leaf >= 7)
+	{
+		GetCpuId(7, 0, regs);
+		avx2	 = (regs[1] & (1u << 5)) != 0;
+		avx512bw = (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 30)) != 0;
+		gfni	 = (regs[2] & (1u << 8)) != 0;
+	}
+
+#ifdef NLED_GFNI_KERNEL
+	if(avx && zmm_state && avx512bw && gfni)
+		return nled::TransposeKernel::GFNI;
+#endif
+
+	if(avx && ymm_state && avx2)
+		return nled::TransposeKernel::AVX2;
+
+	return nled::TransposeKernel::SSE2;
+}
+
+#else
+
+static nled::TransposeKernel DetectTransposeKernel()
+{
+	return nled::TransposeKernel::Scalar;
+}
+
+#endif // NLED_X86
+
+
+//////////////////////////////////////////////////////////////////////////
+// Dispatch
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Returns the fastest kernel supported by this cpu
+**/
+nled::TransposeKernel nled::GetBestTransposeKernel()
+{
+	static const TransposeKernel best_kernel = DetectTransposeKernel();
+	return best_kernel;
+}
+
+
+
+/**
+@brief Kernels are ordered, every kernel up to the best one is supported
+**/
+bool nled::IsTransposeKernelSupported(TransposeKernel inKernel)
+{
+	return (int)inKernel <= (int)GetBestTransposeKernel();
+}
+
+
+
+/**
+@brief Returns the transpose function associated with a kernel and pin count
+**/
+nled::TransposeFunction nled::GetTransposeFunction(TransposeKernel inKernel, int inPinCount)
+{
+	// Every kernel falls back to the next slower one for the groups it can't handle
+	static const TransposeFunction scalar_functions[] = { Transpose8Scalar, Transpose16Scalar, Transpose32Scalar };
+#ifdef NLED_X86
+	static const TransposeFunction sse2_functions[] = { Transpose8SSE2, Transpose16SSE2, Transpose32SSE2 };
+	static const TransposeFunction avx2_functions[] = { Transpose8AVX2, Transpose16AVX2, Transpose32AVX2 };
+#endif
+#ifdef NLED_GFNI_KERNEL
+	static const TransposeFunction gfni_functions[] = { Transpose8GFNI, Transpose16GFNI, Transpose32GFNI };
+#endif
+
+	assert(inPinCount == 8 || inPinCount == 16 || inPinCount == 32);
+	int pin_index = inPinCount == 32 ? 2 : (inPinCount == 16 ? 1 : 0);
+
+	if(!IsTransposeKernelSupported(inKernel))
+		return scalar_functions[pin_index];
+
+	switch(inKernel)
+	{
+#ifdef NLED_X86
+	case TransposeKernel::SSE2:
+		return sse2_functions[pin_index];
+	case TransposeKernel::AVX2:
+		return avx2_functions[pin_index];
+#endif
+#ifdef NLED_GFNI_KERNEL
+	case TransposeKernel::GFNI:
+		return gfni_functions[pin_index];
+#endif
+	default:
+		return scalar_functions[pin_index];
+	}
+}
+
+
+
+/**
+@brief Returns the kernel name
+**/
+const char* nled::GetTransposeKernelName(TransposeKernel inKernel)
+{
+	switch(inKernel)
+	{
+	case TransposeKernel::SSE2:
+		return "SSE2";
+	case TransposeKernel::AVX2:
+		return "AVX2";
+	case TransposeKernel::GFNI:
+		return "AVX512-GFNI";
+	default:
+		return "Scalar";
+	}
+}
@@ -0,0 +1,173 @@
+#include <nledworkers.h>
+
+// Thread priorities
+#include <nledrealtime.h>
+
+// Standard Includes
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+// Namespace
+using namespace std;
+
+/**
+@brief Tasks submitted by a single RunTasks call, lives on the stack of the caller
+**/
+struct WorkerJob
+{
+	nled::WorkerTask	mTask;								//< Function to run for every task
+	void*				mContext;							//< Passed on to every task
+	int					mTaskCount;							//< Amount of tasks
+	atomic<int>			mNextTask;							//< Next task to pick up
+	int					mFinishedTasks;						//< Amount of finished tasks, guarded by sMutex
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Statics local to this module
+//////////////////////////////////////////////////////////////////////////
+static vector<thread>			sWorkers;									//< All running worker threads
+static deque<WorkerJob*>		sJobs;										//< Jobs that still have tasks to pick up
+static mutex					sMutex;										//< Guards the job queue and finished task counts
+static condition_variable		sJobAvailable;								//< Signaled when a job is queued or the workers need to stop
+static condition_variable		sJobFinished;								//< Signaled when the last task of a job finished
+static bool						sStopWorkers(false);						//< Tells the workers to exit
+
+
+//////////////////////////////////////////////////////////////////////////
+// Module specific functionality
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Marks a task of the job as finished, wakes up the submitting thread when it was the last one
+**/
+static void FinishTask(WorkerJob& ioJob)
+{
+	lock_guard<mutex> lock(sMutex);
+	if(++ioJob.mFinishedTasks == ioJob.mTaskCount)
+		sJobFinished.notify_all();
+}
+
+
+
+/**
+@brief Worker thread, picks up tasks of the oldest job until told to stop
+**/
+static void RunWorker()
+{
+	unique_lock<mutex> lock(sMutex);
+	while(!sStopWorkers)
+	{
+		if(sJobs.empty())
+		{
+			sJobAvailable.wait(lock);
+			continue;
+		}
+
+		// Remove the job once all of it's tasks are picked up
+		WorkerJob* job = sJobs.front();
+		int index = job->mNextTask++;
+		if(index >= job->mTaskCount)
+		{
+			sJobs.pop_front();
+			continue;
+		}
+
+		lock.unlock();
+		job->mTask(job->mContext, index);
+		FinishTask(*job);
+		lock.lock();
+	}
+}
+
+
+
+/**
+@brief Starts the worker threads
+**/
+void nled::StartWorkers(int inThreadCount)
+{
+	StopWorkers();
+
+	sStopWorkers = false;
+	for(int i=0; i < inThreadCount; i++)
+	{
+		sWorkers.push_back(thread(RunWorker));
+		ConfigureThread(sWorkers.back(), ThreadRole::Conversion);
+	}
+}
+
+
+
+/**
+@brief Stops the worker threads
+**/
+void nled::StopWorkers()
+{
+	{
+		lock_guard<mutex> lock(sMutex);
+		sStopWorkers = true;
+	}
+	sJobAvailable.notify_all();
+
+	for(thread& worker : sWorkers)
+		worker.join();
+	sWorkers.clear();
+}
+
+
+
+/**
+@brief Returns the amount of running worker threads
+**/
+int nled::GetWorkerCount()
+{
+	return (int)sWorkers.size();
+}
+
+
+
+/**
+@brief Runs the tasks on the workers and the calling thread
+**/
+void nled::RunTasks(WorkerTask inTask, void* inContext, int inTaskCount)
+{
+	// Nothing to share
+	if(inTaskCount <= 1 || sWorkers.empty())
+	{
+		for(int i=0; i < inTaskCount; i++)
+			inTask(inContext, i);
+		return;
+	}
+
+	WorkerJob job;
+	job.mTask = inTask;
+	job.mContext = inContext;
+	job.mTaskCount = inTaskCount;
+	job.mNextTask = 0;
+	job.mFinishedTasks = 0;
+
+	{
+		lock_guard<mutex> lock(sMutex);
+		sJobs.push_back(&job);
+	}
+	sJobAvailable.notify_all();
+
+	// Help out until all tasks are picked up
+	for(int index = job.mNextTask++; index < inTaskCount; index = job.mNextTask++)
+	{
+		inTask(inContext, index);
+		FinishTask(job);
+	}
+
+	// Wait for the tasks picked up by the workers, the job can't be referenced afterwards
+	unique_lock<mutex> lock(sMutex);
+	deque<WorkerJob*>::iterator it = find(sJobs.begin(), sJobs.end(), &job);
+	if(it != sJobs.end())
+		sJobs.erase(it);
+	sJobFinished.wait(lock, [&job] { return job.mFinishedTasks == job.mTaskCount; });
+}
@@ -0,0 +1,479 @@
+#include <nledwriter.h>
+
+// Led devices
+#include <nleddevice.h>
+
+// Thread priorities
+#include <nledrealtime.h>
+
+// Standard Includes
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#endif
+
+// Namespace
+using namespace std;
+
+#ifdef __linux__
+
+/**
+@brief Writer thread and the devices it writes
+**/
+struct EventWriter
+{
+	thread					mThread;						//< Thread that writes the devices
+	int						mPollHandle;					//< Epoll instance, waits on the devices, the wake up event and the timer
+	int						mWakeHandle;					//< Event descriptor, signaled when the transmit state of a device changed
+	int						mTimerHandle;					//< Timer descriptor, expires when the next frame is due
+	mutex					mMutex;							//< Guards the device list and stop request
+	vector<NLedDevice*>		mDevices;						//< Devices written by this thread
+	bool					mStop;							//< Tells the thread to exit
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Statics local to this module
+//////////////////////////////////////////////////////////////////////////
+const static int				sMaxEvents(32);								//< Amount of events handled per epoll wait
+const static chrono::milliseconds	sDrainPollTime(1);						//< Time between output queue checks while a slave frame drains
+static vector<EventWriter*>		sWriters;									//< All running writers
+static nled::WriteReady			sReady(nullptr);							//< Decides when a frame starts
+static nled::WriteEvent			sStarted(nullptr);							//< Called when the write of a frame starts
+static nled::WriteEvent			sFinished(nullptr);							//< Called when the write of a frame finished
+static nled::WriteEvent			sFailed(nullptr);							//< Called when the rest of a frame can't be written
+static nled::WriteEvent			sTimedOut(nullptr);							//< Called when a frame made no progress for the write timeout
+static chrono::milliseconds		sWriteTimeout(1000);						//< Time a frame gets to make progress before the write gives up on it
+
+
+//////////////////////////////////////////////////////////////////////////
+// Module specific functionality
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Waits for the descriptor of a device to become writable, the event fires once
+**/
+static void WaitForWritable(EventWriter& inWriter, NLedDevice* inDevice)
+{
+	epoll_event event;
+	event.events = EPOLLOUT | EPOLLONESHOT;
+	event.data.ptr = inDevice;
+	epoll_ctl(inWriter.mPollHandle, EPOLL_CTL_MOD, inDevice->mConnection.getFileDescriptor(), &event);
+}
+
+
+
+/**
+@brief Gives up on the frame of a device that made no progress for the write timeout, returns if it did
+
+Otherwise sets ioWakeUp to when the write times out
+**/
+static bool TimeOutDevice(NLedDevice* inDevice, chrono::steady_clock::time_point inNow, chrono::steady_clock::time_point& ioWakeUp)
+{
+	chrono::steady_clock::time_point give_up = inDevice->mTransmitProgress + sWriteTimeout;
+	if(inNow < give_up)
+	{
+		ioWakeUp = min(ioWakeUp, give_up);
+		return false;
+	}
+
+	cout << "ERROR: write to led device on port: " << inDevice->mPortInfo.port << " timed out\n";
+	sTimedOut(inDevice, inNow);
+	sFinished(inDevice, inNow);
+	return true;
+}
+
+
+
+/**
+@brief Writes as much of the frame handed to a device as the serial driver accepts
+
+Sets ioWakeUp when the device needs to be looked at again without an event,
+a frame that isn't due yet, a slave frame that's still draining or a write that times out
+**/
+static void AdvanceDevice(EventWriter& inWriter, NLedDevice* inDevice, chrono::steady_clock::time_point& ioWakeUp)
+{
+	lock_guard<mutex> lock(inDevice->mTransmitMutex);
+	if(inDevice->mTransmitData == nullptr)
+		return;
+
+	// Wait for the tick of the frame
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if(!inDevice->mTransmitStarted)
+	{
+		chrono::steady_clock::time_point retry;
+		if(!sReady(inDevice, now, retry))
+		{
+			ioWakeUp = min(ioWakeUp, retry);
+			return;
+		}
+		inDevice->mTransmitStarted = true;
+		inDevice->mTransmitWritten = 0;
+		inDevice->mTransmitProgress = now;
+		sStarted(inDevice, now);
+	}
+
+	// Write what's converted until the driver buffer is full, a driver that accepts nothing is waited for like a full one
+	int handle = inDevice->mConnection.getFileDescriptor();
+	while(inDevice->mTransmitWritten < inDevice->mTransmitSize)
+	{
+		ssize_t written = ::write(handle, inDevice->mTransmitData + inDevice->mTransmitWritten, inDevice->mTransmitSize - inDevice->mTransmitWritten);
+		if(written > 0)
+		{
+			inDevice->mTransmitWritten += (int)written;
+			inDevice->mTransmitProgress = now;
+			continue;
+		}
+		if(written < 0 && errno == EINTR)
+			continue;
+		if(written == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			if(!TimeOutDevice(inDevice, now, ioWakeUp))
+				WaitForWritable(inWriter, inDevice);
+			return;
+		}
+
+		// Drop the rest of the frame
+		cout << "ERROR: unable to write to led device on port: " << inDevice->mPortInfo.port << ", " << strerror(errno) << "\n";
+		sFailed(inDevice, now);
+		sFinished(inDevice, now);
+		return;
+	}
+
+	// The rest of a streamed frame follows once it's converted, the time out starts when it's handed over
+	if(inDevice->mTransmitWritten < inDevice->mByteSize)
+	{
+		inDevice->mTransmitProgress = now;
+		return;
+	}
+
+	// Slaves are primed once the frame left the serial driver
+	int queued(0);
+	if(inDevice->mSyncSlave && ioctl(handle, TIOCOUTQ, &queued) == 0 && queued > 0)
+	{
+		if(!TimeOutDevice(inDevice, now, ioWakeUp))
+			ioWakeUp = min(ioWakeUp, now + sDrainPollTime);
+		return;
+	}
+
+	sFinished(inDevice, now);
+}
+
+
+
+/**
+@brief Sets the timer to expire at inWakeUp, a time point of max disarms it
+**/
+static void SetWakeUpTimer(EventWriter& inWriter, chrono::steady_clock::time_point inWakeUp)
+{
+	itimerspec timer;
+	memset(&timer, 0, sizeof(timer));
+	if(inWakeUp != chrono::steady_clock::time_point::max())
+	{
+		// The steady clock is the monotonic clock, zero would disarm the timer
+		long long ns = max<long long>(chrono::duration_cast<chrono::nanoseconds>(inWakeUp.time_since_epoch()).count(), 1);
+		timer.it_value.tv_sec = (time_t)(ns / 1000000000);
+		timer.it_value.tv_nsec = (long)(ns % 1000000000);
+	}
+	timerfd_settime(inWriter.mTimerHandle, TFD_TIMER_ABSTIME, &timer, nullptr);
+}
+
+
+
+/**
+@brief Writer thread, advances every device on every event
+
+Devices are advanced round robin, every device gets what the serial driver accepts before the next one is written
+**/
+static void RunWriter(EventWriter* inWriter)
+{
+	epoll_event events[sMaxEvents];
+	while(true)
+	{
+		chrono::steady_clock::time_point wake_up = chrono::steady_clock::time_point::max();
+		{
+			lock_guard<mutex> lock(inWriter->mMutex);
+			if(inWriter->mStop)
+				return;
+
+			for(NLedDevice* device : inWriter->mDevices)
+				AdvanceDevice(*inWriter, device, wake_up);
+		}
+		SetWakeUpTimer(*inWriter, wake_up);
+
+		// Reset the wake up event and timer, device events are one shot
+		int count = epoll_wait(inWriter->mPollHandle, events, sMaxEvents, -1);
+		for(int i=0; i<count; i++)
+		{
+			if(events[i].data.ptr != nullptr)
+				continue;
+
+			uint64_t value;
+			if(read(inWriter->mWakeHandle, &value, sizeof(value)) < 0 && errno != EAGAIN)
+				cout << "WARNING: unable to reset led writer wake up event\n";
+			if(read(inWriter->mTimerHandle, &value, sizeof(value)) < 0 && errno != EAGAIN)
+				cout << "WARNING: unable to reset led writer timer\n";
+		}
+	}
+}
+
+
+
+/**
+@brief Signals the wake up event of a writer
+**/
+static void WakeUp(EventWriter& inWriter)
+{
+	uint64_t value(1);
+	if(write(inWriter.mWakeHandle, &value, sizeof(value)) < 0)
+		cout << "WARNING: unable to wake up led writer\n";
+}
+
+
+
+/**
+@brief Closes the descriptors of a writer and deletes it
+**/
+static void DeleteWriter(EventWriter* inWriter)
+{
+	if(inWriter->mTimerHandle >= 0)
+		close(inWriter->mTimerHandle);
+	if(inWriter->mWakeHandle >= 0)
+		close(inWriter->mWakeHandle);
+	if(inWriter->mPollHandle >= 0)
+		close(inWriter->mPollHandle);
+	delete inWriter;
+}
+
+
+
+/**
+@brief Creates a writer and starts it's thread, returns null when the descriptors can't be created
+**/
+static EventWriter* CreateWriter()
+{
+	EventWriter* writer = new EventWriter();
+	writer->mStop = false;
+	writer->mPollHandle = epoll_create1(EPOLL_CLOEXEC);
+	writer->mWakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	writer->mTimerHandle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(writer->mPollHandle < 0 || writer->mWakeHandle < 0 || writer->mTimerHandle < 0)
+	{
+		DeleteWriter(writer);
+		return nullptr;
+	}
+
+	// The wake up event and timer are told apart from devices by their null pointer
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = nullptr;
+	epoll_ctl(writer->mPollHandle, EPOLL_CTL_ADD, writer->mWakeHandle, &event);
+	epoll_ctl(writer->mPollHandle, EPOLL_CTL_ADD, writer->mTimerHandle, &event);
+
+	writer->mThread = thread(RunWriter, writer);
+	nled::ConfigureThread(writer->mThread, nled::ThreadRole::Output);
+	return writer;
+}
+
+
+
+/**
+@brief Returns if the event driven writer is available on this platform
+**/
+bool nled::IsWriterSupported()
+{
+	return true;
+}
+
+
+
+/**
+@brief Starts inThreadCount writer threads, stops the previous writers first
+**/
+bool nled::StartWriters(int inThreadCount, chrono::milliseconds inWriteTimeout, WriteReady inReady, WriteEvent inStarted, WriteEvent inFinished, WriteEvent inFailed, WriteEvent inTimedOut)
+{
+	StopWriters();
+
+	sWriteTimeout = inWriteTimeout;
+	sReady = inReady;
+	sStarted = inStarted;
+	sFinished = inFinished;
+	sFailed = inFailed;
+	sTimedOut = inTimedOut;
+	for(int i=0; i<max(inThreadCount, 1); i++)
+	{
+		EventWriter* writer = CreateWriter();
+		if(writer == nullptr)
+		{
+			cout << "ERROR: unable to create led writer, " << strerror(errno) << "\n";
+			StopWriters();
+			return false;
+		}
+		sWriters.push_back(writer);
+	}
+	return true;
+}
+
+
+
+/**
+@brief Stops all writer threads
+**/
+void nled::StopWriters()
+{
+	for(EventWriter* writer : sWriters)
+	{
+		{
+			lock_guard<mutex> lock(writer->mMutex);
+			writer->mStop = true;
+		}
+		WakeUp(*writer);
+		writer->mThread.join();
+		DeleteWriter(writer);
+	}
+	sWriters.clear();
+}
+
+
+
+/**
+@brief Returns the amount of running writer threads
+**/
+int nled::GetWriterCount()
+{
+	return (int)sWriters.size();
+}
+
+
+
+/**
+@brief Hands the device to the writer with the least devices
+**/
+bool nled::AddWriterDevice(NLedDevice& ioDevice)
+{
+	int handle = ioDevice.mConnection.getFileDescriptor();
+	if(sWriters.empty() || handle < 0)
+		return false;
+
+	int index(0);
+	for(int i=1; i<(int)sWriters.size(); i++)
+	{
+		if(sWriters[i]->mDevices.size() < sWriters[index]->mDevices.size())
+			index = i;
+	}
+
+	// Errors and hang ups are reported once, the device is armed when a write doesn't fit
+	EventWriter& writer = *sWriters[index];
+	lock_guard<mutex> lock(writer.mMutex);
+	epoll_event event;
+	event.events = EPOLLONESHOT;
+	event.data.ptr = &ioDevice;
+	if(epoll_ctl(writer.mPollHandle, EPOLL_CTL_ADD, handle, &event) != 0)
+		return false;
+
+	ioDevice.mTransmitStarted = false;
+	ioDevice.mWriterIndex = index;
+	writer.mDevices.push_back(&ioDevice);
+	return true;
+}
+
+
+
+/**
+@brief Takes the device away from it's writer
+**/
+void nled::RemoveWriterDevice(NLedDevice& ioDevice)
+{
+	if(ioDevice.mWriterIndex < 0)
+		return;
+
+	EventWriter& writer = *sWriters[ioDevice.mWriterIndex];
+	lock_guard<mutex> lock(writer.mMutex);
+	epoll_ctl(writer.mPollHandle, EPOLL_CTL_DEL, ioDevice.mConnection.getFileDescriptor(), nullptr);
+	writer.mDevices.erase(remove(writer.mDevices.begin(), writer.mDevices.end(), &ioDevice), writer.mDevices.end());
+	ioDevice.mWriterIndex = -1;
+}
+
+
+
+/**
+@brief Hands the new descriptor of a reopened device to it's writer
+**/
+bool nled::ResetWriterDevice(NLedDevice& ioDevice)
+{
+	if(ioDevice.mWriterIndex < 0)
+		return false;
+
+	EventWriter& writer = *sWriters[ioDevice.mWriterIndex];
+	lock_guard<mutex> lock(writer.mMutex);
+	epoll_event event;
+	event.events = EPOLLONESHOT;
+	event.data.ptr = &ioDevice;
+	return epoll_ctl(writer.mPollHandle, EPOLL_CTL_ADD, ioDevice.mConnection.getFileDescriptor(), &event) == 0;
+}
+
+
+
+/**
+@brief Wakes up the writer of a device
+**/
+void nled::WakeWriter(const NLedDevice& inDevice)
+{
+	if(inDevice.mWriterIndex >= 0)
+		WakeUp(*sWriters[inDevice.mWriterIndex]);
+}
+
+#else
+
+/**
+@brief The event driven writer needs epoll, devices keep their own transmit threads
+**/
+bool nled::IsWriterSupported()
+{
+	return false;
+}
+
+bool nled::StartWriters(int inThreadCount, chrono::milliseconds inWriteTimeout, WriteReady inReady, WriteEvent inStarted, WriteEvent inFinished, WriteEvent inFailed, WriteEvent inTimedOut)
+{
+	return false;
+}
+
+void nled::StopWriters()
+{
+}
+
+int nled::GetWriterCount()
+{
+	return 0;
+}
+
+bool nled::AddWriterDevice(NLedDevice& ioDevice)
+{
+	return false;
+}
+
+void nled::RemoveWriterDevice(NLedDevice& ioDevice)
+{
+}
+
+bool nled::ResetWriterDevice(NLedDevice& ioDevice)
+{
+	return false;
+}
+
+void nled::WakeWriter(const NLedDevice& inDevice)
+{
+}
+
+#endif
@@ -153,6 +153,12 @@ get_sysfs_info(const string& device_path)
 
     string hardware_id;
 
+    string vendor_id;
+
+    string product_id;
+
+    string serial_number;
+
     string sys_device_path = format( "/sys/class/tty/%s/device", device_name.c_str() );
 
     if( device_name.compare(0,6,"ttyUSB") == 0 )
@@ -164,6 +170,12 @@ get_sysfs_info(const string& device_path)
             friendly_name = usb_sysfs_friendly_name( sys_device_path );
 
             hardware_id = usb_sysfs_hw_string( sys_device_path );
+
+            vendor_id = read_line( sys_device_path + "/idVendor" );
+
+            product_id = read_line( sys_device_path + "/idProduct" );
+
+            serial_number = read_line( sys_device_path + "/serial" );
         }
     }
     else if( device_name.compare(0,6,"ttyACM") == 0 )
@@ -175,6 +187,12 @@ get_sysfs_info(const string& device_path)
             friendly_name = usb_sysfs_friendly_name( sys_device_path );
 
             hardware_id = usb_sysfs_hw_string( sys_device_path );
+
+            vendor_id = read_line( sys_device_path + "/idVendor" );
+
+            product_id = read_line( sys_device_path + "/idProduct" );
+
+            serial_number = read_line( sys_device_path + "/serial" );
         }
     }
     else
@@ -196,6 +214,9 @@ get_sysfs_info(const string& device_path)
     vector<string> result;
     result.push_back(friendly_name);
     result.push_back(hardware_id);
+    result.push_back(vendor_id);
+    result.push_back(product_id);
+    result.push_back(serial_number);
 
     return result;
 }
@@ -324,6 +345,9 @@ serial::list_ports()
         device_entry.port = device;
         device_entry.description = friendly_name;
         device_entry.hardware_id = hardware_id;
+        device_entry.vendor_id = sysfs_info[2];
+        device_entry.product_id = sysfs_info[3];
+        device_entry.serial_number = sysfs_info[4];
         
         results.push_back( device_entry );
 
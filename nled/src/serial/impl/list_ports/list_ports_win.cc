@@ -21,6 +21,7 @@ using std::string;
 static const DWORD port_name_max_length = 256;
 static const DWORD friendly_name_max_length = 256;
 static const DWORD hardware_id_max_length = 256;
+static const DWORD instance_id_max_length = 256;
 
 // Convert a wide Unicode string to an UTF8 string
 std::string utf8_encode(const std::wstring &wstr)
@@ -125,14 +126,30 @@ serial::list_ports()
 		else
 			hardware_id[0] = '\0';
 
+		// Get instance ID
+
+		TCHAR instance_id[instance_id_max_length];
+
+		BOOL got_instance_id = SetupDiGetDeviceInstanceId(
+					device_info_set,
+					&device_info_data,
+					instance_id,
+					instance_id_max_length,
+					NULL);
+
+		if(got_instance_id != TRUE)
+			instance_id[0] = '\0';
+
 		#ifdef UNICODE
 			std::string portName = utf8_encode(port_name);
 			std::string friendlyName = utf8_encode(friendly_name);
 			std::string hardwareId = utf8_encode(hardware_id);
+			std::string instanceId = utf8_encode(instance_id);
 		#else
 			std::string portName = port_name;
 			std::string friendlyName = friendly_name;
 			std::string hardwareId = hardware_id;
+			std::string instanceId = instance_id;
 		#endif
 
 		PortInfo port_entry;
@@ -140,6 +157,25 @@ serial::list_ports()
 		port_entry.description = friendlyName;
 		port_entry.hardware_id = hardwareId;
 
+		// USB ids are part of the hardware ID (USB\VID_16C0&PID_0483...)
+
+		size_t vid_pos = hardwareId.find("VID_");
+		size_t pid_pos = hardwareId.find("PID_");
+
+		if(vid_pos != std::string::npos && pid_pos != std::string::npos)
+		{
+			port_entry.vendor_id = hardwareId.substr(vid_pos + 4, 4);
+			port_entry.product_id = hardwareId.substr(pid_pos + 4, 4);
+		}
+
+		// The serial number is the last part of the instance ID (USB\VID_16C0&PID_0483\12345),
+		// devices without one get an ID made up by windows, those contain a '&'
+
+		size_t serial_pos = instanceId.rfind('\\');
+
+		if(instanceId.compare(0, 4, "USB\\") == 0 && serial_pos != std::string::npos && instanceId.find('&', serial_pos) == std::string::npos)
+			port_entry.serial_number = instanceId.substr(serial_pos + 1);
+
 		devices_found.push_back(port_entry);
 	}
 
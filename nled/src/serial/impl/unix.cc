@@ -474,6 +474,12 @@ Serial::SerialImpl::isOpen () const
   return is_open_;
 }
 
+int
+Serial::SerialImpl::getFileDescriptor () const
+{
+  return is_open_ ? fd_ : -1;
+}
+
 size_t
 Serial::SerialImpl::available ()
 {
@@ -488,6 +494,20 @@ Serial::SerialImpl::available ()
   }
 }
 
+size_t
+Serial::SerialImpl::outputQueued ()
+{
+  if (!is_open_) {
+    return 0;
+  }
+  int count = 0;
+  if (-1 == ioctl (fd_, TIOCOUTQ, &count)) {
+      THROW (IOException, errno);
+  } else {
+      return static_cast<size_t> (count);
+  }
+}
+
 bool
 Serial::SerialImpl::waitReadable (uint32_t timeout)
 {
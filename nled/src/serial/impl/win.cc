@@ -287,6 +287,12 @@ Serial::SerialImpl::isOpen () const
   return is_open_;
 }
 
+int
+Serial::SerialImpl::getFileDescriptor () const
+{
+  return -1;
+}
+
 size_t
 Serial::SerialImpl::available ()
 {
@@ -302,6 +308,21 @@ Serial::SerialImpl::available ()
   return static_cast<size_t>(cs.cbInQue);
 }
 
+size_t
+Serial::SerialImpl::outputQueued ()
+{
+  if (!is_open_) {
+    return 0;
+  }
+  COMSTAT cs;
+  if (!ClearCommError(fd_, NULL, &cs)) {
+    stringstream ss;
+    ss << "Error while checking status of the serial port: " << GetLastError();
+    THROW (IOException, ss.str().c_str());
+  }
+  return static_cast<size_t>(cs.cbOutQue);
+}
+
 bool
 Serial::SerialImpl::waitReadable (uint32_t timeout)
 {
@@ -95,12 +95,24 @@ Serial::isOpen () const
   return pimpl_->isOpen ();
 }
 
+int
+Serial::getFileDescriptor () const
+{
+  return pimpl_->getFileDescriptor ();
+}
+
 size_t
 Serial::available ()
 {
   return pimpl_->available ();
 }
 
+size_t
+Serial::outputQueued ()
+{
+  return pimpl_->outputQueued ();
+}
+
 bool
 Serial::waitReadable ()
 {
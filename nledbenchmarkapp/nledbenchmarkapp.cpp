@@ -0,0 +1,290 @@
+// nledbenchmarkapp.cpp : Defines the entry point for the console application.
+//
+
+// Standard h
+#include "stdafx.h"
+
+// Led lib
+#include <nled.h>
+#include <nledconversion.h>
+
+// std libs
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <stdlib.h>
+
+// namespace
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////
+// Measures the led conversion throughput of every conversion engine
+//
+// No hardware is required, the benchmark creates a synthetic led device,
+// fills both panels with random frames and converts them a number of times
+// for every engine and thread count. The output of every run is compared
+// against the scalar reference.
+//
+// Usage: nledbenchmarkapp [-width 120] [-height 64] [-layout 1] [-pins 8]
+//                         [-format rgb|rgbw|white] [-frames 500]
+//                         [-threads 1,2,4] [-tracking off|explicit|hash]
+//                         [-static] [-csv]
+//
+// -static converts the same frame over and over, -csv prints one line per
+// run that can be tracked across releases.
+//
+// Every engine is verified against a golden model by nledverifyapp.
+//////////////////////////////////////////////////////////////////////////
+
+static const int	sFramePoolSize(4);				//< Amount of distinct random frames cycled through
+
+/**
+@brief Benchmark settings, set from the command line
+**/
+struct BenchmarkSettings
+{
+	int						mStripLength = 120;					//< Amount of leds on one strip
+	int						mLedHeight = 64;					//< Amount of leds in height
+	bool					mLayout = true;						//< Left to right / right to left
+	int						mPinCount = 8;						//< Amount of parallel output pins
+	string					mFormat = "rgb";					//< rgb, rgbw or white (rgbw leds, white extracted from rgb)
+	int						mFrameCount = 500;					//< Amount of frames to convert per run
+	vector<int>				mThreadCounts = { 1 };				//< Thread counts to run every engine with
+	nled::DirtyTracking		mTracking = nled::DirtyTracking::Off;	//< Dirty tracking mode
+	bool					mStatic = false;					//< Convert the same frame every time
+	bool					mCSV = false;						//< Print machine readable output
+};
+
+/**
+@brief Result of converting the frames with a single engine and thread count
+**/
+struct BenchmarkResult
+{
+	double					mNsPerLed;							//< Nano seconds per led
+	double					mLedsPerSecond;						//< Leds converted per second
+	double					mFramesPerSecond;					//< Frames converted per second
+	bool					mIdentical;							//< If the output matches the scalar reference
+};
+
+
+
+/**
+@brief Parses the command line, returns false when an argument is invalid
+**/
+bool ParseArguments(int argc, _TCHAR* argv[], BenchmarkSettings& outSettings)
+{
+	for(int i=1; i<argc; i++)
+	{
+		string arg = argv[i];
+		string value = i + 1 < argc ? argv[i + 1] : "";
+
+		if(arg == "-static")		{ outSettings.mStatic = true; continue; }
+		if(arg == "-csv")			{ outSettings.mCSV = true; continue; }
+
+		if(value.empty())
+		{
+			cout << "ERROR: missing value for argument: " << arg << "\n";
+			return false;
+		}
+		i++;
+
+		if(arg == "-width")			outSettings.mStripLength = atoi(value.c_str());
+		else if(arg == "-height")	outSettings.mLedHeight = atoi(value.c_str());
+		else if(arg == "-layout")	outSettings.mLayout = atoi(value.c_str()) != 0;
+		else if(arg == "-pins")		outSettings.mPinCount = atoi(value.c_str());
+		else if(arg == "-format")	outSettings.mFormat = value;
+		else if(arg == "-frames")	outSettings.mFrameCount = atoi(value.c_str());
+		else if(arg == "-threads")
+		{
+			outSettings.mThreadCounts.clear();
+			for(size_t begin = 0; begin < value.size();)
+			{
+				size_t end = value.find(',', begin);
+				end = end == string::npos ? value.size() : end;
+				outSettings.mThreadCounts.push_back(atoi(value.substr(begin, end - begin).c_str()));
+				begin = end + 1;
+			}
+		}
+		else if(arg == "-tracking")
+		{
+			if(value == "off")				outSettings.mTracking = nled::DirtyTracking::Off;
+			else if(value == "explicit")	outSettings.mTracking = nled::DirtyTracking::Explicit;
+			else if(value == "hash")		outSettings.mTracking = nled::DirtyTracking::RowHash;
+			else
+			{
+				cout << "ERROR: unknown dirty tracking mode: " << value << "\n";
+				return false;
+			}
+		}
+		else
+		{
+			cout << "ERROR: unknown argument: " << arg << "\n";
+			return false;
+		}
+	}
+
+	// Validate settings
+	if(outSettings.mPinCount != 8 && outSettings.mPinCount != 16 && outSettings.mPinCount != 32)
+	{
+		cout << "ERROR: pin count needs to be 8, 16 or 32\n";
+		return false;
+	}
+	if(outSettings.mStripLength <= 0 || outSettings.mLedHeight <= 0 || outSettings.mLedHeight % outSettings.mPinCount != 0)
+	{
+		cout << "ERROR: invalid geometry, height needs to be a multiple of the pin count\n";
+		return false;
+	}
+	if(outSettings.mFormat != "rgb" && outSettings.mFormat != "rgbw" && outSettings.mFormat != "white")
+	{
+		cout << "ERROR: unknown pixel format: " << outSettings.mFormat << "\n";
+		return false;
+	}
+	for(int thread_count : outSettings.mThreadCounts)
+	{
+		if(thread_count <= 0)
+		{
+			cout << "ERROR: thread counts need to be larger than 0\n";
+			return false;
+		}
+	}
+	if(outSettings.mFrameCount <= 0 || outSettings.mThreadCounts.empty())
+	{
+		cout << "ERROR: frame count and thread counts need to be specified\n";
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Points the device to frame inFrame of the pool and flags it as changed
+**/
+void SelectFrame(NLedDevice& inDevice, vector<vector<unsigned char>>& inFrames, int inFrame)
+{
+	inDevice.mRGBDataPanelOne = inFrames[(inFrame * 2) + 0].data();
+	inDevice.mRGBDataPanelTwo = inFrames[(inFrame * 2) + 1].data();
+	nled::MarkRowsDirty(inDevice, 0, 0, -1);
+	nled::MarkRowsDirty(inDevice, 1, 0, -1);
+}
+
+
+
+/**
+@brief Converts the configured amount of frames with the given engine and compares the last one against the reference
+**/
+BenchmarkResult BenchmarkEngine(NLedDevice& inDevice, const BenchmarkSettings& inSettings, nled::ConversionEngine inEngine, vector<vector<unsigned char>>& inFrames, const vector<vector<unsigned char>>& inReference)
+{
+	// Warm up caches
+	SelectFrame(inDevice, inFrames, 0);
+	PixelsToLed(&inDevice, inEngine);
+
+	int frame(0);
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for(int i=0; i<inSettings.mFrameCount; i++)
+	{
+		if(!inSettings.mStatic)
+		{
+			frame = i % sFramePoolSize;
+			SelectFrame(inDevice, inFrames, frame);
+		}
+		PixelsToLed(&inDevice, inEngine);
+	}
+	chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+
+	double ns = (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+	double leds = (double)inSettings.mFrameCount * inDevice.mStripLength * inDevice.mLedHeight;
+
+	BenchmarkResult result;
+	result.mNsPerLed = ns / leds;
+	result.mLedsPerSecond = leds / (ns * 1e-9);
+	result.mFramesPerSecond = inSettings.mFrameCount / (ns * 1e-9);
+	result.mIdentical = memcmp(inReference[frame].data(), inDevice.mConvertedData, inDevice.mByteSize) == 0;
+	return result;
+}
+
+
+
+/**
+@brief Main compute function
+**/
+int _tmain(int argc, _TCHAR* argv[])
+{
+	BenchmarkSettings settings;
+	if(!ParseArguments(argc, argv, settings))
+		return -1;
+
+	// Create the conversion tables
+	nled::InitConversion(1.75f);
+
+	// Create a synthetic device
+	PortInfo port_info;
+	NLedDevice device(port_info);
+	device.mStripLength = settings.mStripLength;
+	device.mLedHeight = settings.mLedHeight;
+	device.mLayout = settings.mLayout;
+	device.mPinCount = settings.mPinCount;
+	nled::CreateConversionBuffers(device);
+	if(settings.mFormat != "rgb")
+		nled::SetPixelFormat(device, nled::PixelFormat::RGBW, settings.mFormat == "white");
+
+	// Fill the panels of every frame with random color data
+	int panel_size = (settings.mLedHeight / 2) * settings.mStripLength * device.mDisplayBytesPerLed;
+	vector<vector<unsigned char>> frames(sFramePoolSize * 2, vector<unsigned char>(panel_size));
+	mt19937 generator(0);
+	for(vector<unsigned char>& panel : frames)
+	{
+		for(unsigned char& v : panel)
+			v = (unsigned char)generator();
+	}
+
+	// Create the reference output of every frame, the scalar engine falls back to the table for devices it can't handle
+	nled::SetDirtyTracking(nled::DirtyTracking::Off);
+	vector<vector<unsigned char>> reference;
+	for(int i=0; i<sFramePoolSize; i++)
+	{
+		SelectFrame(device, frames, i);
+		PixelsToLed(&device, nled::ConversionEngine::Scalar);
+		reference.push_back(vector<unsigned char>(device.mConvertedData, device.mConvertedData + device.mByteSize));
+	}
+
+	if(settings.mCSV)
+		cout << "engine,threads,width,height,layout,pins,format,tracking,static,frames,ns_per_led,leds_per_second,frames_per_second,identical\n";
+	else
+		cout << "Device: " << settings.mStripLength << " x " << settings.mLedHeight << ", " << settings.mPinCount << " pins, " << settings.mFormat << ", " << settings.mFrameCount << " frames\n\n";
+
+	nled::SetDirtyTracking(settings.mTracking);
+	nled::ConversionEngine engines[] = { nled::ConversionEngine::Scalar, nled::ConversionEngine::Transpose, nled::ConversionEngine::Table };
+	const char* tracking_names[] = { "off", "explicit", "hash" };
+	for(int thread_count : settings.mThreadCounts)
+	{
+		nled::SetConversionThreadCount(thread_count);
+		for(nled::ConversionEngine engine : engines)
+		{
+			// The scalar reference only knows 8 pins and RGB, it would measure the table instead
+			if(engine == nled::ConversionEngine::Scalar && (settings.mPinCount != 8 || settings.mFormat != "rgb"))
+				continue;
+
+			BenchmarkResult result = BenchmarkEngine(device, settings, engine, frames, reference);
+			if(settings.mCSV)
+			{
+				printf("%s,%d,%d,%d,%d,%d,%s,%s,%d,%d,%.4f,%.0f,%.2f,%d\n", nled::GetConversionEngineName(engine), thread_count, settings.mStripLength, settings.mLedHeight,
+					settings.mLayout ? 1 : 0, settings.mPinCount, settings.mFormat.c_str(), tracking_names[(int)settings.mTracking], settings.mStatic ? 1 : 0, settings.mFrameCount,
+					result.mNsPerLed, result.mLedsPerSecond, result.mFramesPerSecond, result.mIdentical ? 1 : 0);
+			}
+			else
+			{
+				printf("%-10s %2d threads %8.3f ns/led %8.2f Mleds/s %10.1f frames/s %s\n", nled::GetConversionEngineName(engine), thread_count,
+					result.mNsPerLed, result.mLedsPerSecond * 1e-6, result.mFramesPerSecond, result.mIdentical ? "" : "OUTPUT MISMATCH");
+			}
+		}
+	}
+
+	nled::DeleteConversionBuffers(device);
+	nled::ClearConversion();
+
+	return 0;
+}
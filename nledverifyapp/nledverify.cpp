@@ -0,0 +1,667 @@
+// Standard h
+#include "stdafx.h"
+
+// Verification
+#include "nledverify.h"
+
+// Led lib
+#include <nled.h>
+#include <nledconversion.h>
+#include <nledtranspose.h>
+
+// std libs
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// namespace
+using namespace std;
+
+/**
+@brief Pixel data every case is filled with
+**/
+enum PixelPattern
+{
+	PatternRandom		= 0,
+	PatternBlack		= 1,
+	PatternWhite		= 2,
+	PatternSingleBit	= 3,						//< All black except for a single bit
+	PatternGradient		= 4,
+	PatternCount		= 5,
+};
+
+/**
+@brief How a case is converted by the engine under test
+**/
+enum VerifyMode
+{
+	ModeFull			= 0,						//< Single threaded, every strip row converted
+	ModeThreaded		= 1,						//< Strip rows split over multiple threads
+	ModeExplicit		= 2,						//< Previous frame converted first, changed rows flagged with MarkRowsDirty
+	ModeRowHash			= 3,						//< Previous frame converted first, changed rows detected by hashing
+	ModeStreamed		= 4,						//< Previous frame converted first, changed rows detected by hashing, converted in random sized chunks
+	ModeCount			= 5,
+};
+
+static const char*		sModeNames[] = { "full", "threaded", "incremental explicit", "incremental hash", "streamed" };
+static const char*		sFormatNames[] = { "rgb", "rgbw", "white" };
+static const char*		sRotationNames[] = { "none", "cw90", "cw180", "cw270" };
+static const char*		sPatternNames[] = { "random", "black", "white", "single bit", "gradient" };
+
+/**
+@brief A single verification case, the pixel data is generated from the seed
+**/
+struct VerifyCase
+{
+	int						mStripLength;
+	int						mLedHeight;
+	int						mPinCount;
+	bool					mLayout;
+	int						mFormat;				//< 0: rgb, 1: rgbw, 2: rgbw leds with white extracted from rgb
+	nled::Topology			mTopology;
+	float					mGamma;
+	PixelPattern			mPattern;
+	bool					mSyncSlave;				//< If the frame is send to a frame sync slave
+	float					mFrameRate;				//< Target frame rate the sync pulse is based on
+	unsigned int			mSeed;
+};
+
+static float			sActiveGamma(-1.0f);			//< Gamma the conversion tables are initialized with
+static int				sActiveThreads(-1);				//< Thread count the conversion is initialized with
+
+/**
+@brief Checks the chunks reported by a streamed conversion
+**/
+struct StreamCheck
+{
+	int						mFinalBytes;			//< Amount of final bytes reported by the last chunk
+	bool					mValid;					//< If every chunk grew the final bytes, and the chunks that weren't converted match the previous conversion
+	const unsigned char*	mPrevious;				//< Led data of the previous conversion
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// Golden model
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Returns the amount of display rows and bytes per display row of a single panel
+**/
+static void GetDisplayRows(const VerifyCase& inCase, int& outRowCount, int& outRowSize)
+{
+	bool transposed = inCase.mTopology.mRotation == nled::Rotation::CW90 || inCase.mTopology.mRotation == nled::Rotation::CW270;
+	int panel_height = inCase.mLedHeight / 2;
+	outRowCount = transposed ? inCase.mStripLength : panel_height;
+	outRowSize = (transposed ? panel_height : inCase.mStripLength) * (inCase.mFormat == 1 ? 4 : 3);
+}
+
+
+
+/**
+@brief Returns the display pixel that drives the led at inX along the strip of panel row inY
+**/
+static int GetDisplayPixel(const VerifyCase& inCase, int inX, int inY)
+{
+	int width(inCase.mStripLength), height(inCase.mLedHeight / 2);
+	int x(inX), y(inY), display_width(width), display_height(height);
+
+	// Rotate clockwise, 90 and 270 swap the display dimensions
+	switch(inCase.mTopology.mRotation)
+	{
+	case nled::Rotation::CW90:		x = inY;				y = width - 1 - inX;	display_width = height;	display_height = width;	break;
+	case nled::Rotation::CW180:		x = width - 1 - inX;	y = height - 1 - inY;	break;
+	case nled::Rotation::CW270:		x = height - 1 - inY;	y = inX;				display_width = height;	display_height = width;	break;
+	default:						break;
+	}
+
+	x = inCase.mTopology.mMirrorX ? display_width - 1 - x : x;
+	y = inCase.mTopology.mMirrorY ? display_height - 1 - y : y;
+	return (y * display_width) + x;
+}
+
+
+
+/**
+@brief Converts the panels the way the scalar reference does: wire every led and spread the bits one by one, MSB first
+
+Extended to any pin count, pixel format and topology
+**/
+static vector<unsigned char> GoldenConvert(const VerifyCase& inCase, const unsigned char* inPanelOne, const unsigned char* inPanelTwo)
+{
+	unsigned char gamma[256];
+	for(int i=0; i<256; i++)
+		gamma[i] = (unsigned char)(pow((float)i / 255.0, inCase.mGamma) * 255.0f + 0.5);
+
+	int width(inCase.mStripLength), pins(inCase.mPinCount);
+	int strips_per_pin(inCase.mLedHeight / pins), panel_height(inCase.mLedHeight / 2);
+	int colors = inCase.mFormat == 0 ? 3 : 4;
+	int display_bytes = inCase.mFormat == 1 ? 4 : 3;
+
+	vector<unsigned char> output;
+	int usec = (int)((1000000.0 / inCase.mFrameRate) * 0.75);
+	output.push_back(inCase.mSyncSlave ? '%' : '*');
+	output.push_back((unsigned char)(usec));
+	output.push_back((unsigned char)(usec >> 8));
+
+	unsigned int wired[32];
+	for(int y=0; y<strips_per_pin; y++)
+	{
+		bool serpentine = inCase.mTopology.mOrder == nled::StripOrder::Serpentine;
+		bool left_to_right = serpentine ? (y & 1) == (inCase.mLayout ? 0 : 1) : inCase.mLayout;
+
+		for(int n=0; n<width; n++)
+		{
+			int x = left_to_right ? n : width - 1 - n;
+			for(int i=0; i<pins; i++)
+			{
+				int row = y + (strips_per_pin * i);
+				const unsigned char* panel = row < panel_height ? inPanelOne : inPanelTwo;
+				const unsigned char* color = panel + (GetDisplayPixel(inCase, x, row % panel_height) * display_bytes);
+
+				int red(color[0]), gre(color[1]), blu(color[2]), wht(0);
+				if(inCase.mFormat == 1)
+					wht = color[3];
+				if(inCase.mFormat == 2)
+				{
+					wht = min(red, min(gre, blu));
+					red -= wht;
+					gre -= wht;
+					blu -= wht;
+				}
+
+				// GRB(W) - most common wiring
+				wired[i] = (gamma[gre] << 16) | (gamma[red] << 8) | gamma[blu];
+				if(colors == 4)
+					wired[i] = (wired[i] << 8) | gamma[wht];
+			}
+
+			for(int bit = (colors * 8) - 1; bit >= 0; bit--)
+			{
+				for(int k=0; k<pins/8; k++)
+				{
+					unsigned char b(0);
+					for(int i=0; i<8; i++)
+						b |= ((wired[(k * 8) + i] >> bit) & 1) << i;
+					output.push_back(b);
+				}
+			}
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// Case execution
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Fills both panels of the case with it's pixel pattern
+**/
+static void CreatePanels(const VerifyCase& inCase, vector<unsigned char>& outPanelOne, vector<unsigned char>& outPanelTwo)
+{
+	int row_count, row_size;
+	GetDisplayRows(inCase, row_count, row_size);
+	int size = row_count * row_size;
+
+	mt19937 generator(inCase.mSeed);
+	outPanelOne.assign(size, 0);
+	outPanelTwo.assign(size, 0);
+	for(int i=0; i<size; i++)
+	{
+		switch(inCase.mPattern)
+		{
+		case PatternRandom:		outPanelOne[i] = (unsigned char)generator(); outPanelTwo[i] = (unsigned char)generator(); break;
+		case PatternWhite:		outPanelOne[i] = outPanelTwo[i] = 0xFF; break;
+		case PatternGradient:	outPanelOne[i] = (unsigned char)i; outPanelTwo[i] = (unsigned char)(255 - i); break;
+		default:				break;
+		}
+	}
+
+	if(inCase.mPattern == PatternSingleBit)
+	{
+		vector<unsigned char>& panel = generator() & 1 ? outPanelOne : outPanelTwo;
+		panel[generator() % size] = (unsigned char)(1 << (generator() % 8));
+	}
+}
+
+
+
+/**
+@brief Makes sure the conversion tables and worker threads match the case
+**/
+static void PrepareConversion(float inGamma, int inThreadCount)
+{
+	if(inGamma != sActiveGamma)
+	{
+		nled::InitConversion(inGamma);
+		sActiveGamma = inGamma;
+		sActiveThreads = -1;
+	}
+
+	if(inThreadCount != sActiveThreads)
+	{
+		nled::SetConversionThreadCount(inThreadCount);
+		sActiveThreads = inThreadCount;
+	}
+}
+
+
+
+/**
+@brief Receives the chunks of a streamed conversion, every chunk needs to add final bytes
+
+A chunk that reports no converted rows has to be identical to the previous conversion
+**/
+static void StreamChunkDone(NLedDevice* inDevice, int inByteCount, bool inConverted, void* inContext)
+{
+	StreamCheck& check = *(StreamCheck*)inContext;
+	check.mValid = check.mValid && inByteCount > check.mFinalBytes && inByteCount <= inDevice->mByteSize;
+	if(check.mValid && !inConverted)
+		check.mValid = memcmp(inDevice->mConvertedData + check.mFinalBytes, check.mPrevious + check.mFinalBytes, inByteCount - check.mFinalBytes) == 0;
+	check.mFinalBytes = inByteCount;
+}
+
+
+
+/**
+@brief Converts the panels with the given engine and mode, returns the offset of the first byte that differs from the golden model, -1 when identical
+**/
+static int CheckCase(const VerifyCase& inCase, const vector<unsigned char>& inPanelOne, const vector<unsigned char>& inPanelTwo, nled::ConversionEngine inEngine, VerifyMode inMode, vector<unsigned char>& outExpected, vector<unsigned char>& outResult)
+{
+	PrepareConversion(inCase.mGamma, inMode == ModeThreaded ? 3 : 1);
+	nled::SetTargetFrameRate(inCase.mFrameRate);
+
+	PortInfo port_info;
+	NLedDevice device(port_info);
+	device.mStripLength = inCase.mStripLength;
+	device.mLedHeight = inCase.mLedHeight;
+	device.mPinCount = inCase.mPinCount;
+	device.mLayout = inCase.mLayout;
+	device.mTopology = inCase.mTopology;
+	device.mSyncSlave = inCase.mSyncSlave;
+	nled::CreateConversionBuffers(device);
+	if(inCase.mFormat != 0)
+		nled::SetPixelFormat(device, nled::PixelFormat::RGBW, inCase.mFormat == 2);
+
+	// Incremental modes convert a previous frame first, where some of the rows are different
+	vector<unsigned char> previous_one(inPanelOne), previous_two(inPanelTwo);
+	vector<unsigned char> previous_data;
+	bool incremental = inMode == ModeExplicit || inMode == ModeRowHash || inMode == ModeStreamed;
+	if(incremental)
+	{
+		int row_count, row_size;
+		GetDisplayRows(inCase, row_count, row_size);
+
+		mt19937 generator(inCase.mSeed ^ 0x5bd1e995);
+		for(int r=0; r<row_count; r++)
+		{
+			vector<unsigned char>& panel = generator() & 1 ? previous_one : previous_two;
+			if(generator() % 3 == 0)
+				panel[(r * row_size) + (generator() % row_size)] ^= (unsigned char)(1 + (generator() % 255));
+		}
+
+		nled::SetDirtyTracking(nled::DirtyTracking::Off);
+		device.mRGBDataPanelOne = previous_one.data();
+		device.mRGBDataPanelTwo = previous_two.data();
+		PixelsToLed(&device, inEngine);
+		previous_data.assign(device.mConvertedData, device.mConvertedData + device.mByteSize);
+
+		// Copy the new frame in to the same buffers, flag the rows that changed
+		nled::SetDirtyTracking(inMode == ModeExplicit ? nled::DirtyTracking::Explicit : nled::DirtyTracking::RowHash);
+		for(int r=0; r<row_count * 2; r++)
+		{
+			vector<unsigned char>& panel = r < row_count ? previous_one : previous_two;
+			const vector<unsigned char>& source = r < row_count ? inPanelOne : inPanelTwo;
+			int offset = (r % row_count) * row_size;
+			if(memcmp(panel.data() + offset, source.data() + offset, row_size) == 0)
+				continue;
+
+			memcpy(panel.data() + offset, source.data() + offset, row_size);
+			if(inMode == ModeExplicit)
+				nled::MarkRowsDirty(device, r < row_count ? 0 : 1, r % row_count, 1);
+		}
+	}
+	else
+	{
+		nled::SetDirtyTracking(nled::DirtyTracking::Off);
+		device.mRGBDataPanelOne = previous_one.data();
+		device.mRGBDataPanelTwo = previous_two.data();
+	}
+
+	// Streamed conversions report ever growing chunks that end at the byte size, unconverted chunks keep the previous data
+	StreamCheck stream = { 0, true, previous_data.data() };
+	if(inMode == ModeStreamed)
+	{
+		int chunk_size = 1 + (int)((inCase.mSeed * 2654435761u) % (unsigned int)(device.mByteSize / 2));
+		PixelsToLed(&device, inEngine, chunk_size, StreamChunkDone, &stream);
+	}
+	else
+	{
+		PixelsToLed(&device, inEngine);
+	}
+	nled::SetDirtyTracking(nled::DirtyTracking::Off);
+
+	outResult.assign(device.mConvertedData, device.mConvertedData + device.mByteSize);
+	outExpected = GoldenConvert(inCase, inPanelOne.data(), inPanelTwo.data());
+	nled::DeleteConversionBuffers(device);
+
+	// A broken chunk sequence is reported at the first byte that wasn't final in time
+	if(inMode == ModeStreamed && (!stream.mValid || stream.mFinalBytes != (int)outResult.size()))
+		return stream.mFinalBytes;
+
+	if(outResult.size() != outExpected.size())
+		return 0;
+	for(size_t i=0; i<outResult.size(); i++)
+	{
+		if(outResult[i] != outExpected[i])
+			return (int)i;
+	}
+	return -1;
+}
+
+
+
+/**
+@brief Returns if the engine handles the case itself, the scalar reference falls back to the table for everything but 8 pins, RGB and the default wiring
+**/
+static bool EngineSupportsCase(const VerifyCase& inCase, nled::ConversionEngine inEngine)
+{
+	if(inEngine != nled::ConversionEngine::Scalar)
+		return true;
+
+	const nled::Topology& t = inCase.mTopology;
+	return inCase.mPinCount == 8 && inCase.mFormat == 0 && t.mOrder == nled::StripOrder::Serpentine && t.mRotation == nled::Rotation::None && !t.mMirrorX && !t.mMirrorY;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Returns a one line description of the case
+**/
+static string DescribeCase(const VerifyCase& inCase)
+{
+	const nled::Topology& t = inCase.mTopology;
+	char description[256];
+	snprintf(description, sizeof(description), "%d x %d, %d pins, layout %d, %s, %s %s%s%s, gamma %.3f, %s pattern, %s at %.1f fps, seed %u",
+		inCase.mStripLength, inCase.mLedHeight, inCase.mPinCount, inCase.mLayout ? 1 : 0, sFormatNames[inCase.mFormat],
+		t.mOrder == nled::StripOrder::Serpentine ? "serpentine" : "progressive", sRotationNames[(int)t.mRotation],
+		t.mMirrorX ? " mirror x" : "", t.mMirrorY ? " mirror y" : "", inCase.mGamma, sPatternNames[inCase.mPattern],
+		inCase.mSyncSlave ? "slave" : "master", inCase.mFrameRate, inCase.mSeed);
+	return description;
+}
+
+
+
+/**
+@brief Prints where in the led stream the first difference is found
+**/
+static void PrintDifference(const VerifyCase& inCase, int inOffset, const vector<unsigned char>& inExpected, const vector<unsigned char>& inResult)
+{
+	if(inResult.size() != inExpected.size())
+	{
+		cout << "  output size differs, expected: " << inExpected.size() << " bytes, got: " << inResult.size() << " bytes\n";
+		return;
+	}
+
+	printf("  first difference at byte %d, expected 0x%02X, got 0x%02X", inOffset, inExpected[inOffset], inResult[inOffset]);
+	if(inOffset < sLedCharBufferOffset)
+	{
+		printf(" (sync header)\n");
+		return;
+	}
+
+	// Locate the strip row, led, color bit and pins of the byte
+	int colors = inCase.mFormat == 0 ? 3 : 4;
+	int pin_bytes = inCase.mPinCount / 8;
+	int led_size = colors * 8 * pin_bytes;
+	int offset = inOffset - sLedCharBufferOffset;
+	int bit_index = (offset % led_size) / pin_bytes;
+	int first_pin = ((offset % led_size) % pin_bytes) * 8;
+	printf(" (strip row %d, led %d, color %c bit %d, pins %d-%d)\n", offset / (led_size * inCase.mStripLength), (offset / led_size) % inCase.mStripLength,
+		"GRBW"[bit_index / 8], 7 - (bit_index % 8), first_pin, first_pin + 7);
+}
+
+
+
+/**
+@brief Shrinks a failing case while it keeps failing: geometry first, the pixel data afterwards
+**/
+static void MinimizeCase(VerifyCase& ioCase, vector<unsigned char>& ioPanelOne, vector<unsigned char>& ioPanelTwo, nled::ConversionEngine inEngine, VerifyMode inMode)
+{
+	vector<unsigned char> expected, result, one, two;
+	bool progress(true);
+	while(progress)
+	{
+		progress = false;
+
+		// Candidate cases with smaller geometry or simpler settings
+		vector<VerifyCase> candidates;
+		VerifyCase c = ioCase;
+		if(ioCase.mStripLength > 1)		{ c = ioCase; c.mStripLength = ioCase.mStripLength / 2; candidates.push_back(c); c.mStripLength = ioCase.mStripLength - 1; candidates.push_back(c); }
+		if(ioCase.mLedHeight > ioCase.mPinCount)	{ c = ioCase; c.mLedHeight -= ioCase.mPinCount; candidates.push_back(c); }
+		if(ioCase.mPinCount > 8)		{ c = ioCase; c.mPinCount /= 2; c.mLedHeight = (ioCase.mLedHeight / ioCase.mPinCount) * c.mPinCount; candidates.push_back(c); }
+		if(ioCase.mFormat != 0)			{ c = ioCase; c.mFormat = 0; candidates.push_back(c); }
+		if(ioCase.mTopology.mRotation != nled::Rotation::None)		{ c = ioCase; c.mTopology.mRotation = nled::Rotation::None; candidates.push_back(c); }
+		if(ioCase.mTopology.mOrder != nled::StripOrder::Serpentine)	{ c = ioCase; c.mTopology.mOrder = nled::StripOrder::Serpentine; candidates.push_back(c); }
+		if(ioCase.mTopology.mMirrorX)	{ c = ioCase; c.mTopology.mMirrorX = false; candidates.push_back(c); }
+		if(ioCase.mTopology.mMirrorY)	{ c = ioCase; c.mTopology.mMirrorY = false; candidates.push_back(c); }
+		if(ioCase.mSyncSlave)			{ c = ioCase; c.mSyncSlave = false; candidates.push_back(c); }
+		if(ioCase.mFrameRate != 30.0f)	{ c = ioCase; c.mFrameRate = 30.0f; candidates.push_back(c); }
+
+		for(const VerifyCase& candidate : candidates)
+		{
+			if(!EngineSupportsCase(candidate, inEngine))
+				continue;
+
+			CreatePanels(candidate, one, two);
+			if(CheckCase(candidate, one, two, inEngine, inMode, expected, result) >= 0)
+			{
+				ioCase = candidate;
+				ioPanelOne = one;
+				ioPanelTwo = two;
+				progress = true;
+				break;
+			}
+		}
+	}
+
+	// Clear chunks of pixel data that aren't needed to fail, halving the chunk size every round
+	int size = (int)ioPanelOne.size();
+	for(int chunk = size; chunk > 0; chunk /= 2)
+	{
+		for(int panel = 0; panel < 2; panel++)
+		{
+			vector<unsigned char>& data = panel == 0 ? ioPanelOne : ioPanelTwo;
+			for(int begin = 0; begin < size; begin += chunk)
+			{
+				vector<unsigned char> candidate(data);
+				int end = min(begin + chunk, size);
+				if(all_of(candidate.begin() + begin, candidate.begin() + end, [](unsigned char v) { return v == 0; }))
+					continue;
+
+				fill(candidate.begin() + begin, candidate.begin() + end, (unsigned char)0);
+				bool fails = panel == 0 ?
+					CheckCase(ioCase, candidate, ioPanelTwo, inEngine, inMode, expected, result) >= 0 :
+					CheckCase(ioCase, ioPanelOne, candidate, inEngine, inMode, expected, result) >= 0;
+				if(fails)
+					data = candidate;
+			}
+		}
+	}
+}
+
+
+
+/**
+@brief Prints the non zero bytes of a minimized panel
+**/
+static void PrintPanel(const char* inName, const vector<unsigned char>& inPanel)
+{
+	int printed(0);
+	cout << "  " << inName << ":";
+	for(size_t i=0; i<inPanel.size(); i++)
+	{
+		if(inPanel[i] == 0)
+			continue;
+		if(printed++ == 16)
+		{
+			cout << " ...";
+			break;
+		}
+		printf(" [%d]=0x%02X", (int)i, inPanel[i]);
+	}
+	cout << (printed == 0 ? " all zero\n" : "\n");
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// Fuzzing
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Creates a random case, most cases are small to keep the iterations fast
+**/
+static VerifyCase CreateRandomCase(mt19937& ioGenerator)
+{
+	static const int pin_counts[] = { 8, 16, 32 };
+	static const float gamma_values[] = { 1.0f, 1.75f, 2.2f, 2.8f };
+	static const float frame_rates[] = { 24.0f, 30.0f, 60.0f, 120.0f };
+
+	VerifyCase c;
+	c.mPinCount = pin_counts[ioGenerator() % 3];
+	c.mStripLength = ioGenerator() % 8 == 0 ? 100 + (ioGenerator() % 300) : 1 + (ioGenerator() % 40);
+	c.mLedHeight = c.mPinCount * (1 + (ioGenerator() % 6));
+	c.mLayout = (ioGenerator() & 1) != 0;
+	c.mFormat = ioGenerator() % 3;
+	c.mGamma = ioGenerator() % 2 == 0 ? gamma_values[ioGenerator() % 4] : 1.0f + (float)(ioGenerator() % 2000) / 1000.0f;
+	c.mPattern = ioGenerator() % 4 == 0 ? (PixelPattern)(ioGenerator() % PatternCount) : PatternRandom;
+	c.mSyncSlave = (ioGenerator() & 1) != 0;
+	c.mFrameRate = ioGenerator() % 2 == 0 ? frame_rates[ioGenerator() % 4] : 12.0f + (float)(ioGenerator() % 2280) / 10.0f;
+	c.mSeed = ioGenerator();
+
+	// Half of the cases use the default wiring, so the scalar reference takes part
+	if(ioGenerator() & 1)
+	{
+		c.mPinCount = ioGenerator() & 1 ? 8 : c.mPinCount;
+		c.mLedHeight = c.mPinCount * (1 + (ioGenerator() % 6));
+		c.mFormat = ioGenerator() & 1 ? 0 : c.mFormat;
+	}
+	else
+	{
+		c.mTopology.mOrder = (nled::StripOrder)(ioGenerator() % 2);
+		c.mTopology.mRotation = (nled::Rotation)(ioGenerator() % 4);
+		c.mTopology.mMirrorX = (ioGenerator() & 1) != 0;
+		c.mTopology.mMirrorY = (ioGenerator() & 1) != 0;
+	}
+	return c;
+}
+
+
+
+/**
+@brief Compares every supported transpose kernel against the scalar kernel for random planes, returns the amount of failures
+**/
+static int VerifyTransposeKernels(mt19937& ioGenerator, int inIterations)
+{
+	static const int pin_counts[] = { 8, 16, 32 };
+	nled::TransposeKernel kernels[] = { nled::TransposeKernel::SSE2, nled::TransposeKernel::AVX2, nled::TransposeKernel::GFNI };
+
+	int failures(0);
+	for(nled::TransposeKernel kernel : kernels)
+	{
+		if(!nled::IsTransposeKernelSupported(kernel))
+			continue;
+
+		for(int pins : pin_counts)
+		{
+			nled::TransposeFunction reference = nled::GetTransposeFunction(nled::TransposeKernel::Scalar, pins);
+			nled::TransposeFunction transpose = nled::GetTransposeFunction(kernel, pins);
+			for(int i=0; i<inIterations; i++)
+			{
+				// Group counts around the vector widths catch tail handling errors
+				int groups = ioGenerator() % 200;
+				vector<unsigned char> planes(groups * pins), expected(groups * pins), result(groups * pins);
+				for(unsigned char& v : planes)
+					v = (unsigned char)ioGenerator();
+
+				reference(planes.data(), expected.data(), groups);
+				transpose(planes.data(), result.data(), groups);
+				if(expected != result)
+				{
+					cout << "MISMATCH: " << nled::GetTransposeKernelName(kernel) << " transpose kernel, " << pins << " pins, " << groups << " groups\n";
+					failures++;
+					break;
+				}
+			}
+		}
+	}
+	return failures;
+}
+
+
+
+/**
+@brief Runs the random cases
+**/
+int RunVerification(int inIterations, unsigned int inSeed)
+{
+	float frame_rate = nled::GetTargetFrameRate();
+	mt19937 generator(inSeed);
+	int failures = VerifyTransposeKernels(generator, inIterations);
+
+	nled::ConversionEngine engines[] = { nled::ConversionEngine::Scalar, nled::ConversionEngine::Transpose, nled::ConversionEngine::Table };
+	vector<unsigned char> panel_one, panel_two, expected, result;
+	int checks(0);
+
+	for(int i=0; i<inIterations; i++)
+	{
+		VerifyCase verify_case = CreateRandomCase(generator);
+		CreatePanels(verify_case, panel_one, panel_two);
+
+		for(nled::ConversionEngine engine : engines)
+		{
+			if(!EngineSupportsCase(verify_case, engine))
+				continue;
+
+			for(int mode = 0; mode < ModeCount; mode++)
+			{
+				checks++;
+				if(CheckCase(verify_case, panel_one, panel_two, engine, (VerifyMode)mode, expected, result) < 0)
+					continue;
+
+				failures++;
+				cout << "MISMATCH: " << nled::GetConversionEngineName(engine) << " engine, " << sModeNames[mode] << "\n";
+				cout << "  case:      " << DescribeCase(verify_case) << "\n";
+
+				VerifyCase minimized = verify_case;
+				vector<unsigned char> minimized_one(panel_one), minimized_two(panel_two);
+				MinimizeCase(minimized, minimized_one, minimized_two, engine, (VerifyMode)mode);
+
+				int offset = CheckCase(minimized, minimized_one, minimized_two, engine, (VerifyMode)mode, expected, result);
+				cout << "  minimized: " << DescribeCase(minimized) << "\n";
+				PrintPanel("panel one", minimized_one);
+				PrintPanel("panel two", minimized_two);
+				PrintDifference(minimized, offset, expected, result);
+			}
+		}
+	}
+
+	cout << "Verified " << checks << " conversions of " << inIterations << " random cases, " << failures << " failures\n";
+
+	nled::ClearConversion();
+	nled::SetTargetFrameRate(frame_rate);
+	sActiveGamma = -1.0f;
+	return failures;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Differential verification of the led conversion
+//
+// Every conversion engine is compared bit for bit against a golden model
+// of the scalar reference conversion, over randomized geometries, pin
+// counts, pixel formats, topologies, gamma values, sync roles, frame
+// rates and pixel data. Every engine is run in full, multi threaded,
+// incremental (dirty tracking) and streamed (chunked) mode. The transpose
+// kernels are fuzzed against the scalar kernel.
+//
+// A mismatch is shrunk to a minimal failing case before it's reported.
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Runs inIterations random cases starting from inSeed, returns the amount of failing cases
+**/
+int RunVerification(int inIterations, unsigned int inSeed);
@@ -0,0 +1,87 @@
+// nledverifyapp.cpp : Defines the entry point for the console application.
+//
+
+// Standard h
+#include "stdafx.h"
+
+// Verification
+#include "nledverify.h"
+
+// std libs
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+
+// namespace
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////
+// Verifies every conversion engine against the golden model
+//
+// No hardware is required, see nledverify.h for what's covered. The
+// project runs the verification after every build, a mismatch fails the
+// build.
+//
+// Usage: nledverifyapp [-iterations 1000] [-seed 1]
+//
+// The exit code is the amount of failures.
+//////////////////////////////////////////////////////////////////////////
+
+/**
+@brief Verification settings, set from the command line
+**/
+struct VerifySettings
+{
+	int						mIterations = 1000;					//< Amount of random verification cases
+	unsigned int			mSeed = 1;							//< First seed of the verification cases
+};
+
+
+
+/**
+@brief Parses the command line, returns false when an argument is invalid
+**/
+bool ParseArguments(int argc, _TCHAR* argv[], VerifySettings& outSettings)
+{
+	for(int i=1; i<argc; i++)
+	{
+		string arg = argv[i];
+		string value = i + 1 < argc ? argv[i + 1] : "";
+		if(value.empty())
+		{
+			cout << "ERROR: missing value for argument: " << arg << "\n";
+			return false;
+		}
+		i++;
+
+		if(arg == "-iterations")	outSettings.mIterations = atoi(value.c_str());
+		else if(arg == "-seed")		outSettings.mSeed = (unsigned int)strtoul(value.c_str(), nullptr, 10);
+		else
+		{
+			cout << "ERROR: unknown argument: " << arg << "\n";
+			return false;
+		}
+	}
+
+	// Validate settings
+	if(outSettings.mIterations <= 0)
+	{
+		cout << "ERROR: invalid amount of iterations: " << outSettings.mIterations << "\n";
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+@brief Main compute function
+**/
+int _tmain(int argc, _TCHAR* argv[])
+{
+	VerifySettings settings;
+	if(!ParseArguments(argc, argv, settings))
+		return -1;
+
+	return RunVerification(settings.mIterations, settings.mSeed);
+}